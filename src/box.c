@@ -0,0 +1,441 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "box.h"
+
+#define BOX_BUFFERS 7
+
+static int box_it_alloc(excit_t data)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	it->lower = NULL;
+	it->upper = NULL;
+	it->step = NULL;
+	it->sizes = NULL;
+	it->strides = NULL;
+	it->size_divs = NULL;
+	it->step_divs = NULL;
+	it->buff = NULL;
+	it->cur = NULL;
+	it->stale = 0;
+	it->rank = 0;
+	it->first = 0;
+	it->end = 0;
+	it->size = 0;
+	return EXCIT_SUCCESS;
+}
+
+static void box_it_free(excit_t data)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	free(it->lower);
+	free(it->size_divs);
+}
+
+/*
+ * Allocates lower, upper, step, sizes, strides and the two halves of buff in
+ * a single block, and the divisors in another.
+ */
+static int box_it_alloc_buffers(struct box_it_s *it, ssize_t dim)
+{
+	ssize_t *block = malloc(BOX_BUFFERS * dim * sizeof(ssize_t));
+	struct excit_divisor_s *divs =
+	    malloc(2 * dim * sizeof(struct excit_divisor_s));
+
+	if (!block || !divs) {
+		free(block);
+		free(divs);
+		return -EXCIT_ENOMEM;
+	}
+	free(it->lower);
+	free(it->size_divs);
+	it->size_divs = divs;
+	it->step_divs = divs + dim;
+	it->lower = block;
+	it->upper = block + dim;
+	it->step = block + 2 * dim;
+	it->sizes = block + 3 * dim;
+	it->strides = block + 4 * dim;
+	it->buff = block + 5 * dim;
+	it->cur = it->buff;
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct box_it_s *dst = (struct box_it_s *)ddst->data;
+	const struct box_it_s *src = (const struct box_it_s *)dsrc->data;
+	ssize_t dim = dsrc->dimension;
+	int err = box_it_alloc_buffers(dst, dim);
+
+	if (err)
+		return err;
+	memcpy(dst->lower, src->lower, BOX_BUFFERS * dim * sizeof(ssize_t));
+	memcpy(dst->size_divs, src->size_divs,
+	       2 * dim * sizeof(struct excit_divisor_s));
+	dst->cur = dst->buff + (src->cur - src->buff);
+	dst->stale = src->stale;
+	dst->rank = src->rank;
+	dst->first = src->first;
+	dst->end = src->end;
+	dst->size = src->size;
+	return EXCIT_SUCCESS;
+}
+
+static inline void box_it_decode(const struct box_it_s *it, ssize_t dim,
+				 ssize_t rank, ssize_t *indexes)
+{
+	for (ssize_t i = dim - 1; i >= 0; i--) {
+		ssize_t q = excit_divide(it->size_divs + i, rank);
+
+		indexes[i] = it->lower[i] +
+		    (rank - q * it->sizes[i]) * it->step[i];
+		rank = q;
+	}
+}
+
+/*
+ * Returns the number of steps from lower to val along coordinate i, or -1 if
+ * val is not on the coordinate range.
+ */
+static inline ssize_t box_it_offset(const struct box_it_s *it, ssize_t i,
+				    ssize_t val)
+{
+	ssize_t diff = it->step[i] > 0 ? val - it->lower[i] :
+	    it->lower[i] - val;
+	ssize_t pos;
+
+	if (diff < 0)
+		return -1;
+	pos = excit_divide(it->step_divs + i, diff);
+	return pos * it->step_divs[i].d == diff ? pos : -1;
+}
+
+/* Positions the box on a rank of the full box */
+static void box_it_load(excit_t data, ssize_t rank)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	it->rank = rank;
+	it->stale = 0;
+	if (rank < it->end)
+		box_it_decode(it, data->dimension, rank, it->cur);
+}
+
+static int box_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+
+	*size = it->end - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_rewind(excit_t data)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	box_it_load(data, it->first);
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_seek(excit_t data, ssize_t rank)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	box_it_load(data, it->first + rank);
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Moves the odometer to the next element, building it in the other half of
+ * buff: only the coordinates that wrapped around and the one incremented are
+ * written, along with those that changed since that half was last current.
+ */
+static inline void box_it_advance(excit_t data)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t *next = it->cur == it->buff ? it->buff + dim : it->buff;
+	ssize_t i = dim - 1;
+
+	if (++it->rank >= it->end)
+		return;
+	for (;; i--) {
+		ssize_t v = it->cur[i] + it->step[i];
+
+		if (it->step[i] > 0 ? v <= it->upper[i] : v >= it->upper[i]) {
+			next[i] = v;
+			break;
+		}
+		next[i] = it->lower[i];
+	}
+	if (it->stale < i)
+		memcpy(next + it->stale, it->cur + it->stale,
+		       (i - it->stale) * sizeof(ssize_t));
+	it->cur = next;
+	it->stale = i;
+}
+
+static int box_it_next(excit_t data, ssize_t *indexes)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	box_it_advance(data);
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_next_ref(excit_t data, const ssize_t **tuple)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	*tuple = it->cur;
+	box_it_advance(data);
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_next_delta(excit_t data, ssize_t *indexes,
+			     ssize_t *first_changed_dim)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	*first_changed_dim = it->stale;
+	box_it_advance(data);
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Elements are written a row at a time: along a row of the innermost
+ * coordinate, only that coordinate changes.
+ */
+static int box_it_next_batch(excit_t data, ssize_t max, ssize_t *indexes,
+			     ssize_t *produced)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t inner = dim - 1;
+	ssize_t count = 0;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	while (count < max && it->rank < it->end) {
+		ssize_t run = it->sizes[inner] -
+		    box_it_offset(it, inner, it->cur[inner]);
+
+		if (run > max - count)
+			run = max - count;
+		if (run > it->end - it->rank)
+			run = it->end - it->rank;
+		if (indexes) {
+			ssize_t *out = indexes + count * dim;
+			ssize_t v = it->cur[inner];
+
+			for (ssize_t j = 0; j < run; j++, out += dim) {
+				memcpy(out, it->cur, inner * sizeof(ssize_t));
+				out[inner] = v;
+				v += it->step[inner];
+			}
+		}
+		/* the last element of the run becomes current, then advances */
+		it->cur[inner] += (run - 1) * it->step[inner];
+		it->rank += run - 1;
+		if (it->stale > inner)
+			it->stale = inner;
+		box_it_advance(data);
+		count += run;
+	}
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+
+	if (n < 0 || n >= it->end - it->first)
+		return -EXCIT_EDOM;
+	if (indexes)
+		box_it_decode(it, data->dimension, it->first + n, indexes);
+	return EXCIT_SUCCESS;
+}
+
+static int box_it_rank(const_excit_t data, const ssize_t *indexes,
+		       ssize_t *n)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+	ssize_t rank = 0;
+
+	for (ssize_t i = 0; i < data->dimension; i++) {
+		ssize_t pos = box_it_offset(it, i, indexes[i]);
+
+		if (pos < 0 || pos >= it->sizes[i])
+			return -EXCIT_EINVAL;
+		rank += pos * it->strides[i];
+	}
+	if (rank < it->first || rank >= it->end)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Computes sizes and strides from the coordinate ranges and resets the window
+ * to the full box.
+ */
+static void box_it_update_sizes(excit_t data)
+{
+	struct box_it_s *it = (struct box_it_s *)data->data;
+
+	it->size = 1;
+	for (ssize_t i = data->dimension - 1; i >= 0; i--) {
+		ssize_t l = it->lower[i], u = it->upper[i], s = it->step[i];
+
+		if (s > 0 ? l > u : l < u)
+			it->sizes[i] = 0;
+		else
+			it->sizes[i] = 1 + excit_divide(it->step_divs + i,
+							s > 0 ? u - l : l - u);
+		excit_divisor_init(it->size_divs + i, it->sizes[i]);
+		it->strides[i] = it->size;
+		it->size *= it->sizes[i];
+	}
+	it->first = 0;
+	it->end = it->size;
+}
+
+/*
+ * Cuts along the outermost coordinate when it yields balanced parts, which
+ * are boxes themselves; otherwise parts cover contiguous windows of ranks.
+ */
+static int box_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct box_it_s *it = (const struct box_it_s *)data->data;
+	ssize_t size = it->end - it->first;
+	int outer = it->first == 0 && it->end == it->size &&
+	    it->sizes[0] % n == 0;
+	ssize_t i;
+
+	if (size < n)
+		return -EXCIT_EDOM;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (i = 0; i < n; i++) {
+		results[i] = excit_dup(data);
+		if (!results[i])
+			goto error;
+		struct box_it_s *res_it = (struct box_it_s *)results[i]->data;
+
+		if (outer) {
+			ssize_t block = it->sizes[0] / n;
+
+			res_it->lower[0] = it->lower[0] +
+			    i * block * it->step[0];
+			res_it->upper[0] = res_it->lower[0] +
+			    (block - 1) * it->step[0];
+			box_it_update_sizes(results[i]);
+		} else {
+			res_it->first = it->first +
+			    excit_split_offset(size, n, i);
+			res_it->end = it->first +
+			    excit_split_offset(size, n, i + 1);
+		}
+		box_it_rewind(results[i]);
+	}
+	return EXCIT_SUCCESS;
+error:
+	while (--i >= 0)
+		excit_free(results[i]);
+	return -EXCIT_ENOMEM;
+}
+
+struct excit_func_table_s excit_box_func_table = {
+	box_it_alloc,
+	box_it_free,
+	box_it_copy,
+	box_it_next,
+	box_it_peek,
+	box_it_size,
+	box_it_rewind,
+	box_it_split,
+	box_it_nth,
+	box_it_rank,
+	box_it_pos,
+	box_it_next_batch,
+	NULL,
+	NULL,
+	box_it_seek,
+	box_it_next_ref,
+	box_it_next_delta
+};
+
+int excit_box_init(excit_t it, ssize_t dim, const ssize_t *lower,
+		   const ssize_t *upper, const ssize_t *step)
+{
+	struct box_it_s *box_it;
+	int err;
+
+	if (!it || it->type != EXCIT_BOX || dim <= 0 || !lower || !upper)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; step && i < dim; i++)
+		if (step[i] == 0)
+			return -EXCIT_EINVAL;
+	box_it = (struct box_it_s *)it->data;
+	err = box_it_alloc_buffers(box_it, dim);
+	if (err)
+		return err;
+	for (ssize_t i = 0; i < dim; i++) {
+		box_it->lower[i] = lower[i];
+		box_it->upper[i] = upper[i];
+		box_it->step[i] = step ? step[i] : 1;
+		excit_divisor_init(box_it->step_divs + i,
+				   box_it->step[i] > 0 ? box_it->step[i] :
+				   -box_it->step[i]);
+	}
+	it->dimension = dim;
+	box_it_update_sizes(it);
+	box_it_load(it, 0);
+	return EXCIT_SUCCESS;
+}
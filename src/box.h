@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_BOX_H
+#define EXCIT_BOX_H
+
+#include "excit.h"
+#include "dev/excit.h"
+#include "divide.h"
+
+struct box_it_s {
+	/* Range of each coordinate, as in range iterators */
+	ssize_t *lower;
+	ssize_t *upper;
+	ssize_t *step;
+	/* Size of each coordinate range, and product of inner sizes */
+	ssize_t *sizes;
+	ssize_t *strides;
+	/* Divide by the size and the absolute step of each coordinate */
+	struct excit_divisor_s *size_divs;
+	struct excit_divisor_s *step_divs;
+	/*
+	 * Two halves holding consecutive elements, cur points to the current
+	 * one, as in product iterators.
+	 */
+	ssize_t *buff;
+	ssize_t *cur;
+	/*
+	 * First coordinate from which the other half may differ from cur,
+	 * which is also the first coordinate of cur that may differ from the
+	 * previous element.
+	 */
+	ssize_t stale;
+	/* Rank of the current element */
+	ssize_t rank;
+	/* Window of ranks [first, end) that is iterated */
+	ssize_t first;
+	ssize_t end;
+	/* Size of the full box */
+	ssize_t size;
+};
+
+extern struct excit_func_table_s excit_box_func_table;
+
+#endif //EXCIT_BOX_H
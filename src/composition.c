@@ -109,6 +109,13 @@ static int composition_it_pos(const_excit_t data, ssize_t *n)
 	return excit_pos(it->indexer, n);
 }
 
+static int composition_it_seek(excit_t data, ssize_t rank)
+{
+	struct composition_it_s *it = (struct composition_it_s *)data->data;
+
+	return excit_seek(it->indexer, rank);
+}
+
 static int composition_it_split(const_excit_t data, ssize_t n, excit_t *results)
 {
 	const struct composition_it_s *it = (const struct composition_it_s *)data->data;
@@ -160,7 +167,13 @@ struct excit_func_table_s excit_composition_func_table = {
 	composition_it_split,
 	composition_it_nth,
 	composition_it_rank,
-	composition_it_pos
+	composition_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	composition_it_seek,
+	NULL,
+	NULL
 };
 
 int excit_composition_init(excit_t it, excit_t src, excit_t indexer)
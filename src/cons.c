@@ -7,31 +7,21 @@
  *
  * SPDX-License-Identifier: BSD-3-Clause
  ******************************************************************************/
+#include <string.h>
 #include "dev/excit.h"
 #include "cons.h"
 
-static void circular_fifo_add(struct circular_fifo_s *fifo, ssize_t elem)
+/*
+ * Stores the element of the source iterator just written in slot head of the
+ * ring into its mirror slot, and moves head to the next slot.
+ */
+static void cons_it_push(struct cons_it_s *it)
 {
-	if (fifo->size == fifo->length) {
-		fifo->start = (fifo->start + 1) % fifo->length;
-		fifo->end = (fifo->end + 1) % fifo->length;
-	} else {
-		fifo->end = (fifo->end + 1) % fifo->length;
-		fifo->size++;
-	}
-	fifo->buffer[fifo->end] = elem;
-}
-
-static void circular_fifo_dump(const struct circular_fifo_s *fifo,
-			       ssize_t *vals)
-{
-	ssize_t i;
-	ssize_t j;
+	ssize_t dim = it->it->dimension;
 
-	for (i = 0, j = fifo->start; i < fifo->size; i++) {
-		vals[i] = fifo->buffer[j];
-		j = (j + 1) % fifo->length;
-	}
+	memcpy(it->ring + (it->head + it->n) * dim, it->ring + it->head * dim,
+	       dim * sizeof(ssize_t));
+	it->head = (it->head + 1) % it->n;
 }
 
 static int cons_it_alloc(excit_t data)
@@ -40,11 +30,8 @@ static int cons_it_alloc(excit_t data)
 
 	it->it = NULL;
 	it->n = 0;
-	it->fifo.length = 0;
-	it->fifo.start = 0;
-	it->fifo.end = -1;
-	it->fifo.size = 0;
-	it->fifo.buffer = NULL;
+	it->ring = NULL;
+	it->head = 0;
 	return EXCIT_SUCCESS;
 }
 
@@ -53,7 +40,7 @@ static void cons_it_free(excit_t data)
 	struct cons_it_s *it = (struct cons_it_s *)data->data;
 
 	excit_free(it->it);
-	free(it->fifo.buffer);
+	free(it->ring);
 }
 
 static int cons_it_copy(excit_t ddst, const_excit_t dsrc)
@@ -66,18 +53,13 @@ static int cons_it_copy(excit_t ddst, const_excit_t dsrc)
 		return -EXCIT_EINVAL;
 	dst->it = copy;
 	dst->n = src->n;
-	dst->fifo.length = src->fifo.length;
-	dst->fifo.start = src->fifo.start;
-	dst->fifo.end = src->fifo.end;
-	dst->fifo.size = src->fifo.size;
-	dst->fifo.buffer =
-	    (ssize_t *) malloc(src->fifo.length * sizeof(ssize_t));
-	if (!dst->fifo.buffer) {
+	dst->head = src->head;
+	dst->ring = (ssize_t *) malloc(2 * dsrc->dimension * sizeof(ssize_t));
+	if (!dst->ring) {
 		excit_free(copy);
 		return -EXCIT_ENOMEM;
 	}
-	for (int i = 0; i < dst->fifo.length; i++)
-		dst->fifo.buffer[i] = src->fifo.buffer[i];
+	memcpy(dst->ring, src->ring, 2 * dsrc->dimension * sizeof(ssize_t));
 	return EXCIT_SUCCESS;
 }
 
@@ -152,6 +134,12 @@ static int cons_it_pos(const_excit_t data, ssize_t *n)
 	return EXCIT_SUCCESS;
 }
 
+/* Returns the window of n elements ending with the element in slot head - 1 */
+static inline const ssize_t *cons_it_window(const struct cons_it_s *it)
+{
+	return it->ring + it->head * it->it->dimension;
+}
+
 static int cons_it_peek(const_excit_t data, ssize_t *indexes)
 {
 	const struct cons_it_s *it = (const struct cons_it_s *)data->data;
@@ -163,7 +151,9 @@ static int cons_it_peek(const_excit_t data, ssize_t *indexes)
 		err = excit_peek(it->it, indexes + dim * (n - 1));
 		if (err)
 			return err;
-		circular_fifo_dump(&it->fifo, indexes);
+		memcpy(indexes,
+		       it->ring + ((it->head + 1) % n) * dim,
+		       dim * (n - 1) * sizeof(ssize_t));
 	} else
 		err = excit_peek(it->it, NULL);
 	if (err)
@@ -172,52 +162,73 @@ static int cons_it_peek(const_excit_t data, ssize_t *indexes)
 	return EXCIT_SUCCESS;
 }
 
-static int cons_it_next(excit_t data, ssize_t *indexes)
+static int cons_it_next_ref(excit_t data, const ssize_t **tuple)
 {
 	struct cons_it_s *it = (struct cons_it_s *)data->data;
-	int err;
-	int dim = it->it->dimension;
-	int n = it->n;
+	int err = excit_next(it->it, it->ring + it->head * it->it->dimension);
 
-	if (indexes) {		
-		err = excit_next(it->it, indexes + dim * (n - 1));
-		if (err)
-			return err;
-		circular_fifo_dump(&it->fifo, indexes);
-	} else
-		err = excit_next(it->it, NULL);
 	if (err)
 		return err;
-	if (indexes)
-		for (int i = dim * (n - 1); i < dim * n; i++)
-			circular_fifo_add(&it->fifo, indexes[i]);
+	cons_it_push(it);
+	*tuple = cons_it_window(it);
 	return EXCIT_SUCCESS;
 }
 
-static int cons_it_rewind(excit_t data)
+static int cons_it_next(excit_t data, ssize_t *indexes)
 {
-	struct cons_it_s *it = (struct cons_it_s *)data->data;
-	int err = excit_rewind(it->it);
+	const ssize_t *tuple;
+	int err = cons_it_next_ref(data, &tuple);
 
 	if (err)
 		return err;
-	it->fifo.start = 0;
-	it->fifo.end = -1;
-	it->fifo.size = 0;
+	if (indexes)
+		memcpy(indexes, tuple, data->dimension * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
 
+/* Fills the window with the n - 1 elements preceding the current one. */
+static int cons_it_fill(struct cons_it_s *it)
+{
+	it->head = 0;
 	for (int i = 0; i < it->n - 1; i++) {
 		int err;
 
-		err =
-		    excit_next(it->it, it->fifo.buffer + it->it->dimension * i);
+		err = excit_next(it->it,
+				 it->ring + it->head * it->it->dimension);
 		if (err)
 			return err;
-		it->fifo.size += it->it->dimension;
-		it->fifo.end += it->it->dimension;
+		cons_it_push(it);
 	}
 	return EXCIT_SUCCESS;
 }
 
+static int cons_it_rewind(excit_t data)
+{
+	struct cons_it_s *it = (struct cons_it_s *)data->data;
+	int err = excit_rewind(it->it);
+
+	if (err)
+		return err;
+	return cons_it_fill(it);
+}
+
+static int cons_it_seek(excit_t data, ssize_t rank)
+{
+	struct cons_it_s *it = (struct cons_it_s *)data->data;
+	ssize_t size;
+	int err = cons_it_size(data, &size);
+
+	if (err)
+		return err;
+	/* the window is irrelevant once the source is depleted */
+	if (rank == size)
+		return excit_seek(it->it, rank + it->n - 1);
+	err = excit_seek(it->it, rank);
+	if (err)
+		return err;
+	return cons_it_fill(it);
+}
+
 int excit_cons_init(excit_t it, excit_t src, ssize_t n)
 {
 	ssize_t src_size;
@@ -232,19 +243,18 @@ int excit_cons_init(excit_t it, excit_t src, ssize_t n)
 		return -EXCIT_EINVAL;
 	struct cons_it_s *cons_it = (struct cons_it_s *)it->data;
 
-	free(cons_it->fifo.buffer);
+	free(cons_it->ring);
 	excit_free(cons_it->it);
 	it->dimension = n * src->dimension;
 	cons_it->it = src;
 	cons_it->n = n;
-	cons_it->fifo.length = src->dimension * (n - 1);
-	cons_it->fifo.buffer =
-	    (ssize_t *) malloc(cons_it->fifo.length * sizeof(ssize_t));
-	if (!cons_it->fifo.buffer)
+	cons_it->ring = (ssize_t *) malloc(2 * it->dimension * sizeof(ssize_t));
+	if (!cons_it->ring)
 		return -EXCIT_ENOMEM;
 	err = cons_it_rewind(it);
 	if (err) {
-		free(cons_it->fifo.buffer);
+		free(cons_it->ring);
+		cons_it->ring = NULL;
 		return err;
 	}
 	return EXCIT_SUCCESS;
@@ -261,6 +271,12 @@ struct excit_func_table_s excit_cons_func_table = {
 	NULL,
 	cons_it_nth,
 	cons_it_rank,
-	cons_it_pos
+	cons_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	cons_it_seek,
+	cons_it_next_ref,
+	NULL
 };
 
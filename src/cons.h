@@ -13,18 +13,17 @@
 #include "excit.h"
 #include "dev/excit.h"
 
-struct circular_fifo_s {
-	ssize_t length;
-	ssize_t start;
-	ssize_t end;
-	ssize_t size;
-	ssize_t *buffer;
-};
-
 struct cons_it_s {
 	excit_t it;
 	ssize_t n;
-	struct circular_fifo_s fifo;
+	/*
+	 * Mirrored ring of the last n elements of it: the element in slot i is
+	 * stored both in slots i and i + n, so that every window of n
+	 * consecutive elements is contiguous.
+	 */
+	ssize_t *ring;
+	/* Slot receiving the next element of it */
+	ssize_t head;
 };
 
 extern struct excit_func_table_s excit_cons_func_table;
@@ -0,0 +1,260 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include "dev/excit.h"
+#include "cursor.h"
+
+/* Number of ranks translated at once by batch functions */
+#define CURSOR_BATCH 64
+
+static int cursor_it_alloc(excit_t data)
+{
+	struct cursor_it_s *it = (struct cursor_it_s *)data->data;
+
+	it->space = NULL;
+	it->rank = 0;
+	it->first = 0;
+	it->end = 0;
+	return EXCIT_SUCCESS;
+}
+
+static void cursor_it_free(excit_t data)
+{
+	(void)data;
+}
+
+/* Cursors are copied without copying the space they share */
+static int cursor_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct cursor_it_s *dst = (struct cursor_it_s *)ddst->data;
+	const struct cursor_it_s *src = (const struct cursor_it_s *)dsrc->data;
+
+	dst->space = src->space;
+	dst->rank = src->rank;
+	dst->first = src->first;
+	dst->end = src->end;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+
+	*size = it->end - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_rewind(excit_t data)
+{
+	struct cursor_it_s *it = (struct cursor_it_s *)data->data;
+
+	it->rank = it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_seek(excit_t data, ssize_t rank)
+{
+	struct cursor_it_s *it = (struct cursor_it_s *)data->data;
+
+	it->rank = it->first + rank;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (!indexes)
+		return EXCIT_SUCCESS;
+	return excit_nth(it->space, it->rank, indexes);
+}
+
+static int cursor_it_next(excit_t data, ssize_t *indexes)
+{
+	struct cursor_it_s *it = (struct cursor_it_s *)data->data;
+	int err;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes) {
+		err = excit_nth(it->space, it->rank, indexes);
+		if (err)
+			return err;
+	}
+	it->rank++;
+	return EXCIT_SUCCESS;
+}
+
+/* Consecutive ranks are handed to the space in chunks */
+static int cursor_it_next_batch(excit_t data, ssize_t max, ssize_t *indexes,
+				ssize_t *produced)
+{
+	struct cursor_it_s *it = (struct cursor_it_s *)data->data;
+	ssize_t ranks[CURSOR_BATCH];
+	ssize_t count = 0;
+	int err;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (max > it->end - it->rank)
+		max = it->end - it->rank;
+	while (indexes && count < max) {
+		ssize_t n = max - count < CURSOR_BATCH ?
+		    max - count : CURSOR_BATCH;
+
+		for (ssize_t i = 0; i < n; i++)
+			ranks[i] = it->rank + count + i;
+		err = excit_nth_batch(it->space, n, ranks,
+				      indexes + count * data->dimension);
+		if (err)
+			return err;
+		count += n;
+	}
+	it->rank += max;
+	*produced = max;
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+
+	if (n < 0 || n >= it->end - it->first)
+		return -EXCIT_EDOM;
+	if (!indexes)
+		return EXCIT_SUCCESS;
+	return excit_nth(it->space, it->first + n, indexes);
+}
+
+static int cursor_it_nth_batch(const_excit_t data, ssize_t count,
+			       const ssize_t *ranks, ssize_t *indexes)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+	ssize_t shifted[CURSOR_BATCH];
+	int err;
+
+	for (ssize_t done = 0; done < count; done += CURSOR_BATCH) {
+		ssize_t n = count - done < CURSOR_BATCH ?
+		    count - done : CURSOR_BATCH;
+
+		for (ssize_t i = 0; i < n; i++) {
+			if (ranks[done + i] < 0 ||
+			    ranks[done + i] >= it->end - it->first)
+				return -EXCIT_EDOM;
+			shifted[i] = it->first + ranks[done + i];
+		}
+		if (!indexes)
+			continue;
+		err = excit_nth_batch(it->space, n, shifted,
+				      indexes + done * data->dimension);
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int cursor_it_rank(const_excit_t data, const ssize_t *indexes,
+			  ssize_t *n)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+	ssize_t rank;
+	int err = excit_rank(it->space, indexes, &rank);
+
+	if (err)
+		return err;
+	if (rank < it->first || rank >= it->end)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+/* Parts cover contiguous windows of ranks of the same space */
+static int cursor_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct cursor_it_s *it = (const struct cursor_it_s *)data->data;
+	ssize_t size = it->end - it->first;
+	ssize_t i;
+
+	if (size < n)
+		return -EXCIT_EDOM;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (i = 0; i < n; i++) {
+		results[i] = excit_dup(data);
+		if (!results[i])
+			goto error;
+		struct cursor_it_s *res_it =
+		    (struct cursor_it_s *)results[i]->data;
+
+		res_it->first = it->first + excit_split_offset(size, n, i);
+		res_it->end = it->first + excit_split_offset(size, n, i + 1);
+		res_it->rank = res_it->first;
+	}
+	return EXCIT_SUCCESS;
+error:
+	while (--i >= 0)
+		excit_free(results[i]);
+	return -EXCIT_ENOMEM;
+}
+
+struct excit_func_table_s excit_cursor_func_table = {
+	cursor_it_alloc,
+	cursor_it_free,
+	cursor_it_copy,
+	cursor_it_next,
+	cursor_it_peek,
+	cursor_it_size,
+	cursor_it_rewind,
+	cursor_it_split,
+	cursor_it_nth,
+	cursor_it_rank,
+	cursor_it_pos,
+	cursor_it_next_batch,
+	cursor_it_nth_batch,
+	NULL,
+	cursor_it_seek,
+	NULL,
+	NULL
+};
+
+int excit_cursor_init(excit_t it, const_excit_t space)
+{
+	struct cursor_it_s *cursor_it;
+	ssize_t size;
+	int err;
+
+	if (!it || it->type != EXCIT_CURSOR || !space || !space->func_table)
+		return -EXCIT_EINVAL;
+	if (!space->func_table->nth)
+		return -EXCIT_ENOTSUP;
+	err = excit_size(space, &size);
+	if (err)
+		return err;
+	cursor_it = (struct cursor_it_s *)it->data;
+	cursor_it->space = space;
+	cursor_it->rank = 0;
+	cursor_it->first = 0;
+	cursor_it->end = size;
+	it->dimension = space->dimension;
+	return EXCIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_CURSOR_H
+#define EXCIT_CURSOR_H
+
+#include "excit.h"
+#include "dev/excit.h"
+
+struct cursor_it_s {
+	/* Iterator defining the space, shared and not owned */
+	const_excit_t space;
+	/* Rank of the current element in space */
+	ssize_t rank;
+	/* Window of ranks [first, end) of space that is iterated */
+	ssize_t first;
+	ssize_t end;
+};
+
+extern struct excit_func_table_s excit_cursor_func_table;
+
+#endif //EXCIT_CURSOR_H
@@ -8,7 +8,21 @@ struct excit_s {
 	ssize_t dimension;
 	enum excit_type_e type;
 	void *data;
+	/* Element buffer used by excit_next_ref() when next_ref is missing */
+	ssize_t *ref_buff;
+	ssize_t ref_dim;
 };
 
+/*
+ * Offset of part i when size elements are split into n contiguous parts, the
+ * first size % n parts getting one more element. Does not overflow.
+ */
+static inline ssize_t excit_split_offset(ssize_t size, ssize_t n, ssize_t i)
+{
+	ssize_t rem = size % n;
+
+	return size / n * i + (i < rem ? i : rem);
+}
+
 #endif
 
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_DIVIDE_H
+#define EXCIT_DIVIDE_H
+
+#include <stdint.h>
+#include "excit.h"
+
+/*
+ * Division by a divisor fixed at init time, without a divide instruction:
+ * the quotient is computed with a multiplication and shifts by a magic
+ * number (Granlund and Montgomery, "Division by invariant integers using
+ * multiplication", round-up method). Falls back to a division when 128-bit
+ * integers are not available.
+ */
+struct excit_divisor_s {
+	ssize_t d;
+	uint64_t magic;
+	unsigned int shift1;
+	unsigned int shift2;
+};
+
+#ifdef __SIZEOF_INT128__
+/* 128-bit integers are an extension, which -pedantic warns about */
+__extension__ typedef unsigned __int128 excit_u128;
+#endif
+
+/* Divisors that are not positive are replaced by 1 */
+static inline void excit_divisor_init(struct excit_divisor_s *div, ssize_t d)
+{
+	unsigned int l = 0;
+
+	if (d <= 0)
+		d = 1;
+	div->d = d;
+	/* l = ceil(log2(d)) */
+	while (((uint64_t)1 << l) < (uint64_t)d)
+		l++;
+#ifdef __SIZEOF_INT128__
+	div->magic = (uint64_t)(((excit_u128)(((uint64_t)1 << l) - d)
+				 << 64) / (uint64_t)d) + 1;
+#else
+	div->magic = 0;
+#endif
+	div->shift1 = l ? 1 : 0;
+	div->shift2 = l ? l - 1 : 0;
+}
+
+/* Returns n / d for n >= 0 */
+static inline ssize_t excit_divide(const struct excit_divisor_s *div,
+				   ssize_t n)
+{
+#ifdef __SIZEOF_INT128__
+	uint64_t t = (uint64_t)(((excit_u128)div->magic *
+				 (uint64_t)n) >> 64);
+
+	return (ssize_t)((t + (((uint64_t)n - t) >> div->shift1)) >>
+			 div->shift2);
+#else
+	return n / div->d;
+#endif
+}
+
+#endif //EXCIT_DIVIDE_H
@@ -19,6 +19,14 @@
 #include "index.h"
 #include "tleaf.h"
 #include "loop.h"
+#include "offset.h"
+#include "hilbertnd.h"
+#include "morton.h"
+#include "gilbert.h"
+#include "tile.h"
+#include "box.h"
+#include "plan.h"
+#include "cursor.h"
 
 #define CASE(val)                                                              \
 	case val:                                                              \
@@ -37,6 +45,14 @@ const char *excit_type_name(enum excit_type_e type)
 		CASE(EXCIT_TLEAF);
 		CASE(EXCIT_USER);
 		CASE(EXCIT_LOOP);
+		CASE(EXCIT_OFFSET);
+		CASE(EXCIT_HILBERTND);
+		CASE(EXCIT_MORTON);
+		CASE(EXCIT_GILBERT);
+		CASE(EXCIT_TILE);
+		CASE(EXCIT_BOX);
+		CASE(EXCIT_PLAN);
+		CASE(EXCIT_CURSOR);
 		CASE(EXCIT_TYPE_MAX);
 	default:
 		return NULL;
@@ -107,6 +123,8 @@ int excit_get_func_table(const_excit_t it, const struct excit_func_table_s **fun
 		goto error; \
 	it->func_table = &excit_ ##op## _func_table; \
 	it->dimension = 0; \
+	it->ref_buff = NULL; \
+	it->ref_dim = 0; \
 	if (excit_ ##op## _func_table.alloc(it)) \
 		goto error; \
 }
@@ -143,6 +161,30 @@ excit_t excit_alloc(enum excit_type_e type)
 	case EXCIT_LOOP:
 		ALLOC_EXCIT(loop);
 		break;
+	case EXCIT_OFFSET:
+		ALLOC_EXCIT(offset);
+		break;
+	case EXCIT_HILBERTND:
+		ALLOC_EXCIT(hilbertnd);
+		break;
+	case EXCIT_MORTON:
+		ALLOC_EXCIT(morton);
+		break;
+	case EXCIT_GILBERT:
+		ALLOC_EXCIT(gilbert);
+		break;
+	case EXCIT_TILE:
+		ALLOC_EXCIT(tile);
+		break;
+	case EXCIT_BOX:
+		ALLOC_EXCIT(box);
+		break;
+	case EXCIT_PLAN:
+		ALLOC_EXCIT(plan);
+		break;
+	case EXCIT_CURSOR:
+		ALLOC_EXCIT(cursor);
+		break;
 	default:
 		goto error;
 	}
@@ -169,6 +211,8 @@ excit_t excit_alloc_user(const struct excit_func_table_s *func_table,
 	it->func_table = func_table;
 	it->dimension = 0;
 	it->type = EXCIT_USER;
+	it->ref_buff = NULL;
+	it->ref_dim = 0;
 	if (func_table->alloc(it))
 		goto error;
 	return it;
@@ -186,6 +230,8 @@ excit_t excit_dup(const_excit_t it)
 	result = excit_alloc(it->type);
 	if (!result)
 		return NULL;
+	/* Keep the specialized function table selected at init time, if any */
+	result->func_table = it->func_table;
 	result->dimension = it->dimension;
 	if (it->func_table->copy(result, it))
 		goto error;
@@ -204,6 +250,7 @@ void excit_free(excit_t it)
 	if (it->func_table->free)
 		it->func_table->free(it);
 error:
+	free(it->ref_buff);
 	free(it);
 }
 
@@ -232,6 +279,80 @@ int excit_next(excit_t it, ssize_t *indexes)
 	return it->func_table->next(it, indexes);
 }
 
+int excit_next_ref(excit_t it, const ssize_t **tuple)
+{
+	int err;
+
+	if (!it || !it->func_table || !tuple)
+		return -EXCIT_EINVAL;
+	if (it->func_table->next_ref)
+		return it->func_table->next_ref(it, tuple);
+	if (!it->func_table->next)
+		return -EXCIT_ENOTSUP;
+	if (it->ref_dim != it->dimension || !it->ref_buff) {
+		ssize_t *buff = realloc(it->ref_buff, (it->dimension ?
+					it->dimension : 1) * sizeof(ssize_t));
+
+		if (!buff)
+			return -EXCIT_ENOMEM;
+		it->ref_buff = buff;
+		it->ref_dim = it->dimension;
+	}
+	err = it->func_table->next(it, it->ref_buff);
+	if (err)
+		return err;
+	*tuple = it->ref_buff;
+	return EXCIT_SUCCESS;
+}
+
+int excit_next_delta(excit_t it, ssize_t *indexes, ssize_t *first_changed_dim)
+{
+	int err;
+
+	if (!it || !it->func_table || !first_changed_dim)
+		return -EXCIT_EINVAL;
+	if (it->func_table->next_delta)
+		return it->func_table->next_delta(it, indexes,
+						  first_changed_dim);
+	if (!it->func_table->next)
+		return -EXCIT_ENOTSUP;
+	err = it->func_table->next(it, indexes);
+	if (err)
+		return err;
+	*first_changed_dim = 0;
+	return EXCIT_SUCCESS;
+}
+
+int excit_next_batch(excit_t it, ssize_t max, ssize_t *indexes,
+		     ssize_t *produced)
+{
+	ssize_t count = 0;
+	int err;
+
+	if (!it || !it->func_table)
+		return -EXCIT_EINVAL;
+	if (max <= 0)
+		return -EXCIT_EDOM;
+	if (it->func_table->next_batch) {
+		err = it->func_table->next_batch(it, max, indexes, &count);
+	} else {
+		if (!it->func_table->next)
+			return -EXCIT_ENOTSUP;
+		for (err = EXCIT_SUCCESS; count < max; count++) {
+			err = it->func_table->next(it, indexes ?
+						   indexes + count *
+						   it->dimension : NULL);
+			if (err)
+				break;
+		}
+		if (err == EXCIT_STOPIT && count > 0)
+			err = EXCIT_SUCCESS;
+	}
+	if (produced)
+		*produced = count;
+	return err;
+}
+
 int excit_peek(const_excit_t it, ssize_t *indexes)
 {
 	if (!it || !it->func_table)
@@ -333,6 +454,49 @@ int excit_rank(const_excit_t it, const ssize_t *indexes, ssize_t *n)
 	return it->func_table->rank(it, indexes, n);
 }
 
+int excit_nth_batch(const_excit_t it, ssize_t count, const ssize_t *ranks,
+		    ssize_t *indexes)
+{
+	if (!it || !it->func_table || !ranks)
+		return -EXCIT_EINVAL;
+	if (count <= 0)
+		return -EXCIT_EDOM;
+	if (it->func_table->nth_batch)
+		return it->func_table->nth_batch(it, count, ranks, indexes);
+	if (!it->func_table->nth)
+		return -EXCIT_ENOTSUP;
+	for (ssize_t i = 0; i < count; i++) {
+		int err = it->func_table->nth(it, ranks[i], indexes ?
+					      indexes + i * it->dimension :
+					      NULL);
+
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
+int excit_rank_batch(const_excit_t it, ssize_t count, const ssize_t *indexes,
+		     ssize_t *ranks)
+{
+	if (!it || !it->func_table || !indexes)
+		return -EXCIT_EINVAL;
+	if (count <= 0)
+		return -EXCIT_EDOM;
+	if (it->func_table->rank_batch)
+		return it->func_table->rank_batch(it, count, indexes, ranks);
+	if (!it->func_table->rank)
+		return -EXCIT_ENOTSUP;
+	for (ssize_t i = 0; i < count; i++) {
+		int err = it->func_table->rank(it, indexes + i * it->dimension,
+					       ranks ? ranks + i : NULL);
+
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
 int excit_pos(const_excit_t it, ssize_t *n)
 {
 	if (!it || !it->func_table)
@@ -379,3 +543,60 @@ int excit_skip(excit_t it)
 	return excit_next(it, NULL);
 }
 
+int excit_seek(excit_t it, ssize_t rank)
+{
+	ssize_t size;
+	int err;
+
+	if (!it || !it->func_table)
+		return -EXCIT_EINVAL;
+	err = excit_size(it, &size);
+	if (err)
+		return err;
+	if (rank < 0 || rank > size)
+		return -EXCIT_EDOM;
+	if (it->func_table->seek)
+		return it->func_table->seek(it, rank);
+	err = excit_rewind(it);
+	if (err)
+		return err;
+	for (ssize_t i = 0; i < rank; i++) {
+		err = excit_next(it, NULL);
+		if (err)
+			return err < 0 ? err : -EXCIT_EDOM;
+	}
+	return EXCIT_SUCCESS;
+}
+
+int excit_advance(excit_t it, ssize_t k)
+{
+	ssize_t rank, size;
+	int err;
+
+	if (!it || !it->func_table)
+		return -EXCIT_EINVAL;
+	if (k < 0)
+		return -EXCIT_EDOM;
+	if (it->func_table->seek && it->func_table->pos) {
+		err = excit_pos(it, &rank);
+		if (err == EXCIT_STOPIT)
+			return k ? EXCIT_STOPIT : EXCIT_SUCCESS;
+		if (err)
+			return err;
+		err = excit_size(it, &size);
+		if (err)
+			return err;
+		if (k > size - rank) {
+			err = it->func_table->seek(it, size);
+			return err ? err : EXCIT_STOPIT;
+		}
+		return it->func_table->seek(it, rank + k);
+	}
+	for (ssize_t i = 0; i < k; i++) {
+		err = excit_next(it, NULL);
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
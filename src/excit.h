@@ -70,6 +70,9 @@ enum excit_type_e {
 	/*!<
 	 * Iterator over the cartesian product of iterators.
 	 * The resulting iterator's dimension is the sum of input iterators' dimensions.
+	 * Splitting a product cuts along its outermost iterator when its size
+	 * is a multiple of the number of parts; otherwise each part is a
+	 * product covering a contiguous slice of the iteration space.
 	 */
 	EXCIT_PRODUCT,
 	/*!<
@@ -103,6 +106,49 @@ enum excit_type_e {
 	 * See excit_loop_init() for further explanation.
          */
 	EXCIT_LOOP,
+	/*!<
+	 * Iterator mapping the elements of another iterator to linear offsets.
+	 * The resulting iterator's dimension is 1.
+	 * See excit_offset_init() for further explanation.
+	 */
+	EXCIT_OFFSET,
+	/*!<
+	 * N-dimensional Hilbert space-filling curve.
+	 * See excit_hilbertnd_init() for further explanation.
+	 */
+	EXCIT_HILBERTND,
+	/*!<
+	 * Morton (Z-order) space-filling curve.
+	 * See excit_morton_init() for further explanation.
+	 */
+	EXCIT_MORTON,
+	/*!<
+	 * Generalized Hilbert space-filling curve over any rectangle or cuboid.
+	 * See excit_gilbert_init() for further explanation.
+	 */
+	EXCIT_GILBERT,
+	/*!<
+	 * Iterator walking a box tile by tile.
+	 * Splitting a tile iterator cuts between tiles when it has enough of
+	 * them.
+	 * See excit_tile_init() for further explanation.
+	 */
+	EXCIT_TILE,
+	/*!<
+	 * Dense box of any dimension, equivalent to a product of ranges.
+	 * See excit_box_init() for further explanation.
+	 */
+	EXCIT_BOX,
+	/*!<
+	 * Flat execution plan of another iterator.
+	 * See excit_compile() for further explanation.
+	 */
+	EXCIT_PLAN,
+	/*!<
+	 * Position in the space of another iterator, which is shared.
+	 * See excit_cursor_init() for further explanation.
+	 */
+	EXCIT_CURSOR,
 	/*!< Guard */
 	EXCIT_TYPE_MAX
 };
@@ -168,6 +214,11 @@ int excit_get_data(excit_t it, void **data);
  * own table; if some of the function pointers are set to NULL, the corresponding
  * functionality will be considered unsupported and the broker will return
  * -EXCIT_ENOTSUP.
+ * Functions taking a const_excit_t must not write to the iterator, scratch
+ * buffers included: built-in iterators can be shared by threads calling
+ * these functions concurrently, as long as no function taking an excit_t is
+ * called on them at the same time. User-defined iterators should provide the
+ * same guarantee to be shared, e.g. by cursors (see excit_cursor_init()).
  */
 struct excit_func_table_s {
 	/*
@@ -237,6 +288,60 @@ struct excit_func_table_s {
 	 * Returns EXCIT_SUCCESS, EXCIT_STOPIT or an error code.
 	 */
 	int (*pos)(const_excit_t it, ssize_t *n);
+	/*
+	 * This function is responsible for implementing the batched succession
+	 * functionality of the iterator. It is optional: if NULL, the broker
+	 * falls back to successive calls to next.
+	 * "max" is strictly positive and "produced" is never NULL.
+	 * Returns EXCIT_SUCCESS, EXCIT_STOPIT or an error code.
+	 */
+	int (*next_batch)(excit_t it, ssize_t max, ssize_t *indexes,
+			  ssize_t *produced);
+	/*
+	 * This function is responsible for implementing the batched nth
+	 * functionality of the iterator. It is optional: if NULL, the broker
+	 * falls back to successive calls to nth.
+	 * "count" is strictly positive and "ranks" is never NULL.
+	 * Returns EXCIT_SUCCESS or an error code.
+	 */
+	int (*nth_batch)(const_excit_t it, ssize_t count, const ssize_t *ranks,
+			 ssize_t *indexes);
+	/*
+	 * This function is responsible for implementing the batched rank
+	 * functionality of the iterator. It is optional: if NULL, the broker
+	 * falls back to successive calls to rank.
+	 * "count" is strictly positive and "indexes" is never NULL.
+	 * Returns EXCIT_SUCCESS or an error code.
+	 */
+	int (*rank_batch)(const_excit_t it, ssize_t count,
+			  const ssize_t *indexes, ssize_t *ranks);
+	/*
+	 * This function is responsible for implementing the seek functionality
+	 * of the iterator. "rank" is comprised between 0 and the size of the
+	 * iterator, the latter meaning the iterator is to be depleted.
+	 * Returns EXCIT_SUCCESS or an error code.
+	 */
+	int (*seek)(excit_t it, ssize_t rank);
+	/*
+	 * This function is responsible for implementing the next_ref
+	 * functionality of the iterator: it stores in "tuple" a pointer to the
+	 * current element, owned by the iterator, and increments it. The element
+	 * must remain valid until the next call modifying the iterator. If NULL,
+	 * the element is copied from next into a buffer owned by the iterator.
+	 * "tuple" is never NULL.
+	 * Returns EXCIT_SUCCESS, EXCIT_STOPIT or an error code.
+	 */
+	int (*next_ref)(excit_t it, const ssize_t **tuple);
+	/*
+	 * This function is responsible for implementing the next_delta
+	 * functionality of the iterator: it behaves as next and stores in
+	 * "first_changed_dim" a coordinate such that all the coordinates before
+	 * it are equal to those of the previously returned element. If NULL,
+	 * next is used and 0 is reported. "first_changed_dim" is never NULL.
+	 * Returns EXCIT_SUCCESS, EXCIT_STOPIT or an error code.
+	 */
+	int (*next_delta)(excit_t it, ssize_t *indexes,
+			  ssize_t *first_changed_dim);
 };
 
 /*
@@ -288,6 +393,43 @@ excit_t excit_dup(const_excit_t it);
  */
 void excit_free(excit_t it);
 
+/*
+ * Rewrites an iterator into an equivalent one that is cheaper to iterate:
+ * elements, their order, their ranks and the position of the iterator are
+ * preserved. Products over the whole space of a product factor are flattened,
+ * runs of ranges and boxes inside products are collapsed into boxes (see
+ * excit_product_collapse()), products with a single factor are replaced by
+ * that factor, a range indexed by a range in a composition is folded into a
+ * range, a composition whose indexer is every rank of the source in order is
+ * replaced by the source, and nested repeat or loop iterators are merged.
+ * Rewritten iterators are freed, so other references to iterators inside
+ * the tree become invalid. The structure of the result, e.g. the factors of
+ * a product, may differ from the original.
+ * "it": a pointer to the iterator to rewrite, where the result is stored.
+ * Returns EXCIT_SUCCESS or an error code. On error, the iterator remains
+ * equivalent to the original but its position is undefined.
+ */
+int excit_optimize(excit_t *it);
+
+/*
+ * Compiles an iterator into a plan iterator returning the same elements in
+ * the same order, without going through the function tables of the
+ * iterators of the tree. Ranks are written as mixed-radix digits and each
+ * element is an affine function of the digits: ranges, boxes, products,
+ * repeat, loop and offset iterators, and compositions of such iterators
+ * indexing a single range, are lowered into digits. Other iterators,
+ * including user iterators, are driven by a digit of their own through
+ * their function table. Ranks are computed by a copy of the original
+ * iterator.
+ * "it": the iterator to compile, which is left untouched.
+ * "plan": a pointer where the new plan iterator is stored. The plan starts
+ *         at the position of it, or rewound if it does not support
+ *         excit_pos().
+ * Returns EXCIT_SUCCESS, -EXCIT_ENOTSUP if an iterator that is not lowered
+ * does not support size, or an error code.
+ */
+int excit_compile(const_excit_t it, excit_t *plan);
+
 /*
  * Get the type of an iterator
  * "it": an iterator.
@@ -316,6 +458,54 @@ int excit_dimension(const_excit_t it, ssize_t *dimension);
  */
 int excit_next(excit_t it, ssize_t *indexes);
 
+/*
+ * Gets the current element of an iterator and increments it, without copying
+ * the element.
+ * "it": an iterator.
+ * "tuple": a pointer to a variable where a pointer to the element will be
+ *          stored. The element is owned by the iterator and remains valid
+ *          until the next call modifying the iterator (next, rewind, seek,
+ *          ...) or its release.
+ * Returns EXCIT_SUCCESS, EXCIT_STOPIT if the iterator was already depleted,
+ * or an error code.
+ */
+int excit_next_ref(excit_t it, const ssize_t **tuple);
+
+/*
+ * Gets the current element of an iterator and increments it, reporting which
+ * coordinates changed since the previously returned element.
+ * "it": an iterator.
+ * "indexes": an array of indexes with a dimension corresponding to that of
+ *            the iterator, no results is returned if NULL.
+ * "first_changed_dim": a pointer to a variable where the rank of the first
+ *                      coordinate that may differ from the previously returned
+ *                      element will be stored: all the coordinates before it
+ *                      are unchanged. For a product, this is the first
+ *                      coordinate of the outermost iterator that was
+ *                      incremented. It is 0 for the first element after a
+ *                      rewind or a seek, or when the iterator cannot tell.
+ * Returns EXCIT_SUCCESS, EXCIT_STOPIT if the iterator was already depleted,
+ * or an error code.
+ */
+int excit_next_delta(excit_t it, ssize_t *indexes, ssize_t *first_changed_dim);
+
+/*
+ * Gets up to max successive elements of an iterator and increments it
+ * accordingly. Equivalent to, but cheaper than, up to max calls to
+ * excit_next().
+ * "it": an iterator.
+ * "max": the maximum number of elements to return, must be strictly positive.
+ * "indexes": a pointer to an array of at least max times the dimension of the
+ *            iterator indexes, where the elements will be stored contiguously;
+ *            no result is returned if NULL.
+ * "produced": a pointer to a variable where the number of elements returned
+ *             will be stored; no result is returned if NULL.
+ * Returns EXCIT_SUCCESS if at least one element was returned, EXCIT_STOPIT if
+ * the iterator was already depleted, or an error code.
+ */
+int excit_next_batch(excit_t it, ssize_t max, ssize_t *indexes,
+		     ssize_t *produced);
+
 /*
  * Gets the current element of an iterator.
  * "it": an iterator.
@@ -356,6 +546,8 @@ int excit_split(const_excit_t it, ssize_t n, excit_t *results);
 /*
  * Gets the nth element of an iterator. If an iterator has k dimensions,
  * then the nth element is an array of k nth elements along each dimension.
+ * As other functions taking a const_excit_t, it is thread-safe on built-in
+ * iterators (see struct excit_func_table_s).
  * "it": an iterator.
  * "rank": rank of the element, comprised between 0 and the size of the
  *         iterator.
@@ -379,6 +571,35 @@ int excit_nth(const_excit_t it, ssize_t rank, ssize_t *indexes);
  */
 int excit_rank(const_excit_t it, const ssize_t *element, ssize_t *rank);
 
+/*
+ * Gets the elements of an iterator corresponding to an array of ranks.
+ * Equivalent to, but cheaper than, count calls to excit_nth().
+ * "it": an iterator.
+ * "count": the number of ranks, must be strictly positive.
+ * "ranks": an array of count ranks.
+ * "indexes": a pointer to an array of at least count times the dimension of
+ *            the iterator indexes, where the elements will be stored
+ *            contiguously; no result is returned if NULL.
+ * Returns EXCIT_SUCCESS or an error code. If a rank is out of the iterator
+ * domain, the content of indexes is undefined.
+ */
+int excit_nth_batch(const_excit_t it, ssize_t count, const ssize_t *ranks,
+		    ssize_t *indexes);
+
+/*
+ * Gets the ranks of an array of elements of an iterator.
+ * Equivalent to, but cheaper than, count calls to excit_rank().
+ * "it": an iterator.
+ * "count": the number of elements, must be strictly positive.
+ * "indexes": an array of count elements stored contiguously.
+ * "ranks": a pointer to an array of at least count ranks where the result
+ *          will be stored; no result is returned if NULL.
+ * Returns EXCIT_SUCCESS or an error code. If an element does not belong to the
+ * iterator, the content of ranks is undefined.
+ */
+int excit_rank_batch(const_excit_t it, ssize_t count, const ssize_t *indexes,
+		     ssize_t *ranks);
+
 /*
  * Gets the position of the iterator.
  * "it": an iterator.
@@ -397,6 +618,26 @@ int excit_pos(const_excit_t it, ssize_t *rank);
  */
 int excit_skip(excit_t it);
 
+/*
+ * Increments the iterator k times.
+ * "it": an iterator.
+ * "k": the number of elements to skip, must be positive.
+ * Returns EXCIT_SUCCESS, EXCIT_STOPIT if the iterator was depleted before k
+ * elements could be skipped, or an error code.
+ */
+int excit_advance(excit_t it, ssize_t k);
+
+/*
+ * Moves the iterator so that its current element is the element of the given
+ * rank, i.e., the next call to excit_next() returns excit_nth(rank).
+ * "it": an iterator.
+ * "rank": rank of the element, comprised between 0 and the size of the
+ *         iterator; seeking to the size of the iterator depletes it.
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if rank is out of bounds, or an error
+ * code.
+ */
+int excit_seek(excit_t it, ssize_t rank);
+
 /*
  * Gets the current element of an iterator, rewinding it first if the iterator
  * was depleted. The iterator is incremented.
@@ -467,6 +708,147 @@ int excit_repeat_split(const_excit_t it, ssize_t n, excit_t *results);
  */
 int excit_hilbert2d_init(excit_t it, ssize_t order);
 
+/*
+ * Creates a Hilbert space-filling curve iterator of any dimension.
+ * Consecutive elements are neighbors: they differ by one on a single
+ * coordinate.
+ * "it": a hilbertnd iterator.
+ * "dim": the dimension of the iteration space.
+ * "order": determines the iteration space: [0, 2^order - 1]^dim.
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if the curve has more than
+ * SSIZE_MAX elements, or an error code.
+ */
+int excit_hilbertnd_init(excit_t it, ssize_t dim, ssize_t order);
+
+/*
+ * Creates a Morton (Z-order) space-filling curve iterator. The rank of an
+ * element interleaves the bits of its coordinates, from the least significant
+ * ones, the last coordinate taking the lowest bit of each level. Coordinates
+ * with fewer bits stop taking part in the upper levels. Bits are scattered
+ * with BMI2 instructions when the processor supports them, unless the
+ * EXCIT_MORTON_PORTABLE environment variable is set.
+ * "it": a morton iterator.
+ * "dim": the dimension of the iteration space.
+ * "bits": an array of dim bit widths, coordinate i spans [0, 2^bits[i] - 1].
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if the curve has more than
+ * SSIZE_MAX elements, or an error code.
+ */
+int excit_morton_init(excit_t it, ssize_t dim, const ssize_t *bits);
+
+/*
+ * Creates a generalized Hilbert ("gilbert") space-filling curve iterator over
+ * a rectangle or a cuboid of any size. The curve starts at the origin and
+ * runs along the largest extent. Consecutive elements are neighbors when the
+ * largest extent is even in two dimensions, and when all extents are even in
+ * three dimensions; otherwise a few steps are diagonal or longer.
+ * "it": a gilbert iterator.
+ * "dim": the dimension of the iteration space, 2 or 3.
+ * "sizes": an array of dim extents, coordinate i spans [0, sizes[i] - 1].
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if the curve has more than
+ * SSIZE_MAX elements, or an error code.
+ */
+int excit_gilbert_init(excit_t it, ssize_t dim, const ssize_t *sizes);
+
+/*
+ * Initializes a box iterator, returning the elements of a product of ranges in
+ * row-major order, the last coordinate varying fastest. Coordinate i goes
+ * from lower[i] to upper[i] included, by step[i], as in excit_range_init().
+ * Splitting a box cuts along its first coordinate when it divides evenly,
+ * otherwise parts cover contiguous slices of the box.
+ * "it": a box iterator.
+ * "dim": the dimension of the box.
+ * "lower": an array of dim first values.
+ * "upper": an array of dim last values.
+ * "step": an array of dim non-zero steps, or NULL for steps of 1.
+ * Returns EXCIT_SUCCESS or an error code.
+ */
+int excit_box_init(excit_t it, ssize_t dim, const ssize_t *lower,
+		   const ssize_t *upper, const ssize_t *step);
+
+/*
+ * Initializes a cursor iterator, which iterates over the elements of a space
+ * iterator without copying it: a cursor only holds a window of ranks and
+ * its position, elements are computed by excit_nth() on the space. Copying
+ * or splitting a cursor is thus cheap, and many cursors, e.g. one per
+ * thread, can share a space concurrently. The functions of built-in
+ * iterators that do not move them (nth, rank, size and their batch
+ * versions) can be called concurrently, user iterators must ensure the
+ * same for their nth, rank and size functions.
+ * "it": a cursor iterator.
+ * "space": the iterator to iterate over, ownership is not transferred. It
+ *          must outlive its cursors, and must not be modified while they
+ *          are in use. Its position is ignored.
+ * Returns EXCIT_SUCCESS, -EXCIT_ENOTSUP if space does not support nth, or an
+ * error code.
+ */
+int excit_cursor_init(excit_t it, const_excit_t space);
+
+/*
+ * Initializes a tile iterator, walking a box tile by tile. Tiles on the upper
+ * edges of the box are truncated to the box.
+ * "it": a tile iterator.
+ * "dim": the dimension of the box.
+ * "shape": an array of dim extents, coordinate i spans [0, shape[i] - 1].
+ * "tile_sizes": an array of dim tile extents.
+ * "outer": NULL or the order of the tiles, ownership is transferred. Either
+ *          an iterator of dimension dim returning the coordinates of each
+ *          tile in the grid of tiles (e.g. a hilbert2d or a product
+ *          iterator), or an iterator of dimension 1 returning row-major tile
+ *          indexes. It must return every tile once. If NULL, tiles are walked
+ *          in row-major order.
+ * "inner_order": NULL or a permutation of the dim dimensions, from the
+ *                outermost to the innermost loop inside a tile. If NULL,
+ *                tiles are walked in row-major order.
+ * Returns EXCIT_SUCCESS or an error code.
+ */
+int excit_tile_init(excit_t it, ssize_t dim, const ssize_t *shape,
+		    const ssize_t *tile_sizes, excit_t outer,
+		    const ssize_t *inner_order);
+
+/*
+ * Gets the size and the line size of the data cache of a given level of the
+ * first CPU, from Linux sysfs.
+ * "level": the cache level, 1 for L1.
+ * "size": a pointer to a variable where the size in bytes will be stored.
+ * "line_size": a pointer to a variable where the line size in bytes will be
+ *              stored.
+ * Returns EXCIT_SUCCESS, -EXCIT_ENOTSUP if the information is not available,
+ * or an error code.
+ */
+int excit_cache_info(int level, size_t *size, size_t *line_size);
+
+/*
+ * Chooses tile extents for a box so that a tile fills half of a cache, as
+ * close to cubic as the box allows, with whole cache lines along the innermost
+ * dimension. The result only depends on the arguments.
+ * "dim": the dimension of the box.
+ * "shape": an array of dim extents.
+ * "elem_size": the size in bytes of an element of the box.
+ * "cache_size": the size in bytes of the cache.
+ * "line_size": the line size in bytes of the cache.
+ * "tile_sizes": an array of dim where the tile extents will be stored.
+ * Returns EXCIT_SUCCESS or an error code.
+ */
+int excit_tile_sizes(ssize_t dim, const ssize_t *shape, size_t elem_size,
+		     size_t cache_size, size_t line_size, ssize_t *tile_sizes);
+
+/*
+ * Initializes a tile iterator over a box, walking tiles and their elements in
+ * row-major order, with tile extents fitting a cache level of the machine.
+ * Equivalent to excit_tile_init() with the extents chosen by
+ * excit_tile_sizes() for the cache returned by excit_cache_info(). Use these
+ * functions directly for reproducible extents.
+ * "it": a tile iterator.
+ * "dim": the dimension of the box.
+ * "shape": an array of dim extents.
+ * "elem_size": the size in bytes of an element of the box.
+ * "level": the cache level the tiles must fit in, 1 for L1.
+ * Returns EXCIT_SUCCESS, -EXCIT_ENOTSUP if the cache information is not
+ * available, or an error code.
+ */
+int excit_tile_auto(excit_t it, ssize_t dim, const ssize_t *shape,
+		    size_t elem_size, int level);
+
 /*
  * Adds another iterator to a product iterator.
  * "it": a product iterator.
@@ -484,6 +866,19 @@ int excit_product_add(excit_t it, excit_t added_it);
  */
 int excit_product_add_copy(excit_t it, excit_t added_it);
 
+/*
+ * Replaces each run of consecutive range iterators, or box iterators over
+ * their whole space, inside a product iterator by a single box iterator,
+ * which computes the elements of the run in closed form. Elements and their
+ * order are unchanged, the position is preserved, but the number of iterators
+ * returned by excit_product_count() and the numbering used by
+ * excit_product_split_dim() change accordingly.
+ * "it": a product iterator.
+ * Returns EXCIT_SUCCESS, -EXCIT_ENOTSUP if an iterator of the product does
+ * not support size, or an error code.
+ */
+int excit_product_collapse(excit_t it);
+
 /*
  * Gets the number of iterators inside a product iterator.
  * "it": a product iterator.
@@ -501,11 +896,44 @@ int excit_product_count(const_excit_t it, ssize_t *count);
  * "results": a pointer to an array of at least n excit_t, where the result
  *            will be stored, or NULL in which case no iterator is created.
  * Returns EXCIT_SUCCESS, -EXCIT_EDOM if the selected iterator is too small to
- * be subdivided into the desired number of iterators, or an error code.
+ * be subdivided into the desired number of iterators, -EXCIT_ENOTSUP if the
+ * product only covers a slice of its space (see excit_split()), or an error
+ * code.
  */
 int excit_product_split_dim(const_excit_t it, ssize_t dim, ssize_t n,
 			    excit_t *results);
 
+/*
+ * Splits a product iterator into a grid of blocks, splitting each of its
+ * iterators along the way.
+ * "it": a product iterator.
+ * "parts_per_dim": an array holding, for each iterator of the product, the
+ *                  number of parts it is to be split into (1 leaves it whole).
+ * "results": a pointer to an array of at least the product of parts_per_dim
+ *            excit_t, where the result will be stored, or NULL in which case
+ *            no iterator is created. Blocks are stored in row-major order of
+ *            the grid, the last iterator of the product varying fastest.
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if one of the iterators is too small to
+ * be subdivided into the desired number of parts, -EXCIT_ENOTSUP if the
+ * product only covers a slice of its space, or an error code.
+ */
+int excit_product_split_grid(const_excit_t it, const ssize_t *parts_per_dim,
+			     excit_t *results);
+
+/*
+ * Chooses a grid of n blocks for excit_product_split_grid(), keeping blocks
+ * as close to cubic as the factorization of n allows.
+ * "it": a product iterator.
+ * "n": the total number of blocks desired.
+ * "parts_per_dim": an array with one entry per iterator of the product, where
+ *                  the number of parts of each iterator will be stored. Their
+ *                  product is n.
+ * Returns EXCIT_SUCCESS, -EXCIT_EDOM if n blocks cannot be laid out on the
+ * product, or an error code.
+ */
+int excit_product_split_grid_dims(const_excit_t it, ssize_t n,
+				  ssize_t *parts_per_dim);
+
 /*
  * Initializes a composition iterator by giving a src iterator and an indexer iterator.
  * "it": a composition iterator.
@@ -524,6 +952,25 @@ int excit_composition_init(excit_t it, excit_t src, excit_t indexer);
  */
 int excit_loop_init(excit_t it, excit_t src, ssize_t n);
 
+/*
+ * Initializes an offset iterator by giving a src iterator and the strides of
+ * its coordinates. Each element of src is mapped to:
+ *         base + sum(indexes[d] * strides[d]).
+ * The offset is maintained incrementally: when src is a product, only the
+ * coordinates that changed since the previous element are accounted for.
+ * "it": an offset iterator.
+ * "src": the iterator whose elements are mapped, ownership is transferred.
+ * "strides": an array of strides, one per coordinate of src.
+ * "base": the offset of the origin.
+ * Rank is only supported for nested layouts of ranges, boxes and products of
+ * them: strides must be strictly positive, and each stride must exceed the
+ * span of the offsets of the coordinates with smaller strides, as in row-major
+ * arrays, possibly padded. Rank returns -EXCIT_ENOTSUP otherwise.
+ * Returns EXCIT_SUCCESS or an error code.
+ */
+int excit_offset_init(excit_t it, excit_t src, const ssize_t *strides,
+		      ssize_t base);
+
 enum tleaf_it_policy_e {
   TLEAF_POLICY_ROUND_ROBIN, /* Iterate on tree leaves in a round-robin fashion */
   TLEAF_POLICY_SCATTER, /* Iterate on tree leaves spreading as much as possible */
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_PARALLEL_H
+#define EXCIT_PARALLEL_H 1
+
+#include "excit.h"
+
+/*
+ * Function called on each element of a parallel traversal.
+ * "indexes": the element, an array of dimension values.
+ * "rank": the rank of the element in the iterator, or -1 if it is unknown.
+ * "worker": the index of the calling worker, in [0, nthreads).
+ * "ctx": the context given to excit_parallel_for().
+ * Returns 0 to continue the traversal, or any other value to stop it.
+ */
+typedef int (*excit_parallel_fn_t)(const ssize_t *indexes, ssize_t rank,
+				   int worker, void *ctx);
+
+/*
+ * Calls fn on every element of an iterator using a pool of threads. The whole
+ * iterator is traversed whatever its position, which is left untouched.
+ * Iterators supporting excit_nth() are shared by the workers (see the
+ * function table documentation in excit.h): each worker owns an interval of
+ * ranks that it consumes grain ranks at a time, and idle workers steal half
+ * of the ranks remaining to another worker. Other iterators must provide
+ * their own split function: they are divided once with excit_split(), and
+ * workers steal whole parts. The order in which elements are visited is
+ * unspecified.
+ * "it": the iterator to traverse.
+ * "nthreads": the number of workers, the calling thread included, or 0 for
+ *             the number of online processors.
+ * "grain": the number of consecutive ranks a worker takes at once, or 0 to
+ *          choose one from the size of the iterator.
+ * "fn": the function to call on each element, concurrently.
+ * "ctx": a context given to fn.
+ * Returns EXCIT_SUCCESS, the first non-zero value returned by fn, or an error
+ * code.
+ */
+int excit_parallel_for(const_excit_t it, int nthreads, ssize_t grain,
+		       excit_parallel_fn_t fn, void *ctx);
+
+#endif
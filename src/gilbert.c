@@ -0,0 +1,513 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "gilbert.h"
+
+/*
+ * Helper functions from: https://github.com/jakubcerveny/gilbert
+ * Boxes are recursively split in 2 to 5 boxes, until they are a single row
+ * of points. Two dimensional curves use a third vector of length 1.
+ */
+
+static inline ssize_t sgn(ssize_t x)
+{
+	return (x > 0) - (x < 0);
+}
+
+static inline ssize_t vlen(const ssize_t *v)
+{
+	return labs(v[0] + v[1] + v[2]);
+}
+
+static inline ssize_t box_size(const struct gilbert_box_s *box)
+{
+	return vlen(box->v[0]) * vlen(box->v[1]) * vlen(box->v[2]);
+}
+
+//r = s1 * x + s2 * y
+static inline void vcomb(ssize_t *r, ssize_t s1, const ssize_t *x, ssize_t s2,
+			 const ssize_t *y)
+{
+	for (int i = 0; i < 3; i++)
+		r[i] = s1 * x[i] + s2 * y[i];
+}
+
+//x / 2 rounded towards -inf, with an even length when possible
+static inline void vhalf(ssize_t *r, const ssize_t *x, int even)
+{
+	ssize_t l;
+
+	for (int i = 0; i < 3; i++)
+		r[i] = x[i] >= 0 ? x[i] / 2 : -((1 - x[i]) / 2);
+	l = vlen(r);
+	if (even && (l % 2) && vlen(x) > 2)
+		for (int i = 0; i < 3; i++)
+			r[i] += sgn(x[i]);
+}
+
+static inline void box_set(struct gilbert_box_s *box, const ssize_t *p,
+			   const ssize_t *a, const ssize_t *b, const ssize_t *c)
+{
+	memcpy(box->p, p, sizeof(box->p));
+	memcpy(box->v[0], a, sizeof(box->v[0]));
+	memcpy(box->v[1], b, sizeof(box->v[1]));
+	memcpy(box->v[2], c, sizeof(box->v[2]));
+}
+
+//q = p + sum(coefs[i] * vecs[i])
+static inline void point(ssize_t *q, const ssize_t *p, int n,
+			 const ssize_t *coefs, const ssize_t **vecs)
+{
+	for (int i = 0; i < 3; i++) {
+		q[i] = p[i];
+		for (int j = 0; j < n; j++)
+			q[i] += coefs[j] * vecs[j][i];
+	}
+}
+
+static int gilbert_split2d(const struct gilbert_box_s *box,
+			   struct gilbert_box_s *res)
+{
+	const ssize_t *p = box->p, *a = box->v[0], *b = box->v[1];
+	const ssize_t *c = box->v[2];
+	ssize_t w = vlen(a), h = vlen(b);
+	ssize_t da[3], db[3], a2[3], b2[3], ma[3], mb[3], nb2[3], nma[3];
+	ssize_t q[3];
+
+	for (int i = 0; i < 3; i++) {
+		da[i] = sgn(a[i]);
+		db[i] = sgn(b[i]);
+	}
+	if (2 * w > 3 * h) {
+		vhalf(a2, a, 1);
+		vcomb(ma, 1, a, -1, a2);
+		box_set(res, p, a2, b, c);
+		vcomb(q, 1, p, 1, a2);
+		box_set(res + 1, q, ma, b, c);
+		return 2;
+	}
+	vhalf(a2, a, 0);
+	vhalf(b2, b, 1);
+	vcomb(ma, 1, a, -1, a2);
+	vcomb(mb, 1, b, -1, b2);
+	box_set(res, p, b2, a2, c);
+	vcomb(q, 1, p, 1, b2);
+	box_set(res + 1, q, a, mb, c);
+	point(q, p, 4, (ssize_t[]){1, -1, 1, -1},
+	      (const ssize_t *[]){a, da, b2, db});
+	vcomb(nb2, -1, b2, 0, b2);
+	vcomb(nma, -1, ma, 0, ma);
+	box_set(res + 2, q, nb2, nma, c);
+	return 3;
+}
+
+static int gilbert_split3d(const struct gilbert_box_s *box,
+			   struct gilbert_box_s *res)
+{
+	const ssize_t *p = box->p, *a = box->v[0], *b = box->v[1];
+	const ssize_t *c = box->v[2];
+	ssize_t w = vlen(a), h = vlen(b), d = vlen(c);
+	ssize_t da[3], db[3], dc[3], a2[3], b2[3], c2[3], ma[3], mb[3], mc[3];
+	ssize_t nb2[3], nc2[3], nma[3], nmc[3], nc[3], q[3];
+
+	for (int i = 0; i < 3; i++) {
+		da[i] = sgn(a[i]);
+		db[i] = sgn(b[i]);
+		dc[i] = sgn(c[i]);
+	}
+	vhalf(a2, a, 1);
+	vhalf(b2, b, 1);
+	vhalf(c2, c, 1);
+	vcomb(ma, 1, a, -1, a2);
+	vcomb(mb, 1, b, -1, b2);
+	vcomb(mc, 1, c, -1, c2);
+	vcomb(nb2, -1, b2, 0, b2);
+	vcomb(nc2, -1, c2, 0, c2);
+	vcomb(nma, -1, ma, 0, ma);
+	vcomb(nmc, -1, mc, 0, mc);
+	vcomb(nc, -1, c, 0, c);
+
+	/* wide case, split along a only */
+	if (2 * w > 3 * h && 2 * w > 3 * d) {
+		box_set(res, p, a2, b, c);
+		vcomb(q, 1, p, 1, a2);
+		box_set(res + 1, q, ma, b, c);
+		return 2;
+	}
+	/* do not split along c */
+	if (3 * h > 4 * d) {
+		box_set(res, p, b2, c, a2);
+		vcomb(q, 1, p, 1, b2);
+		box_set(res + 1, q, a, mb, c);
+		point(q, p, 4, (ssize_t[]){1, -1, 1, -1},
+		      (const ssize_t *[]){a, da, b2, db});
+		box_set(res + 2, q, nb2, c, nma);
+		return 3;
+	}
+	/* do not split along b */
+	if (3 * d > 4 * h) {
+		box_set(res, p, c2, a2, b);
+		vcomb(q, 1, p, 1, c2);
+		box_set(res + 1, q, a, b, mc);
+		point(q, p, 4, (ssize_t[]){1, -1, 1, -1},
+		      (const ssize_t *[]){a, da, c2, dc});
+		box_set(res + 2, q, nc2, nma, b);
+		return 3;
+	}
+	/* regular case, split along a, b and c */
+	box_set(res, p, b2, c2, a2);
+	vcomb(q, 1, p, 1, b2);
+	box_set(res + 1, q, c, a2, mb);
+	point(q, p, 4, (ssize_t[]){1, -1, 1, -1},
+	      (const ssize_t *[]){b2, db, c, dc});
+	box_set(res + 2, q, a, nb2, nmc);
+	point(q, p, 5, (ssize_t[]){1, -1, 1, 1, -1},
+	      (const ssize_t *[]){a, da, b2, c, dc});
+	box_set(res + 3, q, nc, nma, mb);
+	point(q, p, 4, (ssize_t[]){1, -1, 1, -1},
+	      (const ssize_t *[]){a, da, b2, db});
+	box_set(res + 4, q, nb2, c2, nma);
+	return 5;
+}
+
+/* End helper functions */
+
+/* Returns the vector of a row, or NULL if the box is not a row */
+static const ssize_t *gilbert_row(const struct gilbert_box_s *box)
+{
+	const ssize_t *row = box->v[0];
+	int count = 0;
+
+	for (int i = 0; i < 3; i++)
+		if (vlen(box->v[i]) > 1) {
+			row = box->v[i];
+			count++;
+		}
+	return count > 1 ? NULL : row;
+}
+
+static inline void gilbert_row_point(const struct gilbert_box_s *box,
+				     ssize_t k, ssize_t dim, ssize_t *val)
+{
+	const ssize_t *row = gilbert_row(box);
+
+	for (ssize_t i = 0; i < dim; i++)
+		val[i] = box->p[i] + k * sgn(row[i]);
+}
+
+/*
+ * Finds the row holding curve index d: stores it in leaf, and the curve index
+ * of its first point in start.
+ */
+static void gilbert_locate(const struct gilbert_box_s *root, ssize_t dim,
+			   ssize_t d, struct gilbert_box_s *leaf,
+			   ssize_t *start)
+{
+	struct gilbert_box_s children[5];
+
+	*leaf = *root;
+	*start = 0;
+	while (!gilbert_row(leaf)) {
+		int count = dim == 2 ? gilbert_split2d(leaf, children) :
+		    gilbert_split3d(leaf, children);
+
+		for (int i = 0; i < count; i++) {
+			ssize_t size = box_size(children + i);
+
+			if (d - *start < size) {
+				*leaf = children[i];
+				break;
+			}
+			*start += size;
+		}
+	}
+}
+
+static int gilbert_box_contains(const struct gilbert_box_s *box,
+				const ssize_t *val)
+{
+	for (int i = 0; i < 3; i++) {
+		const ssize_t *v = box->v[i];
+		ssize_t axis = v[0] ? 0 : (v[1] ? 1 : 2);
+		ssize_t lo = box->p[axis], hi = box->p[axis] + v[axis];
+
+		if (v[axis] == 0)
+			return 0;
+		if (v[axis] > 0 ? val[axis] < lo || val[axis] >= hi :
+		    val[axis] > lo || val[axis] <= hi)
+			return 0;
+	}
+	return 1;
+}
+
+static ssize_t gilbert_rank(const struct gilbert_box_s *root, ssize_t dim,
+			    const ssize_t *val)
+{
+	struct gilbert_box_s children[5], box = *root;
+	const ssize_t *row;
+	ssize_t rank = 0;
+
+	while (!(row = gilbert_row(&box))) {
+		int count = dim == 2 ? gilbert_split2d(&box, children) :
+		    gilbert_split3d(&box, children);
+
+		for (int i = 0; i < count; i++) {
+			if (gilbert_box_contains(children + i, val)) {
+				box = children[i];
+				break;
+			}
+			rank += box_size(children + i);
+		}
+	}
+	for (int i = 0; i < 3; i++)
+		rank += labs(val[i] - box.p[i]);
+	return rank;
+}
+
+static int gilbert_it_alloc(excit_t data)
+{
+	struct gilbert_it_s *it = (struct gilbert_it_s *)data->data;
+
+	it->range_it = NULL;
+	memset(&it->root, 0, sizeof(it->root));
+	it->leaf = it->root;
+	it->leaf_start = 0;
+	it->leaf_size = 0;
+	return EXCIT_SUCCESS;
+}
+
+static void gilbert_it_free(excit_t data)
+{
+	struct gilbert_it_s *it = (struct gilbert_it_s *)data->data;
+
+	excit_free(it->range_it);
+}
+
+static int gilbert_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct gilbert_it_s *dst = (struct gilbert_it_s *)ddst->data;
+	const struct gilbert_it_s *src =
+	    (const struct gilbert_it_s *)dsrc->data;
+	excit_t copy = excit_dup(src->range_it);
+
+	if (!copy)
+		return -EXCIT_EINVAL;
+	dst->range_it = copy;
+	dst->root = src->root;
+	dst->leaf = src->leaf;
+	dst->leaf_start = src->leaf_start;
+	dst->leaf_size = src->leaf_size;
+	return EXCIT_SUCCESS;
+}
+
+static int gilbert_it_rewind(excit_t data)
+{
+	struct gilbert_it_s *it = (struct gilbert_it_s *)data->data;
+
+	return excit_rewind(it->range_it);
+}
+
+static void gilbert_it_d2p(const_excit_t data, ssize_t d, ssize_t *val)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+	struct gilbert_box_s leaf;
+	ssize_t start;
+
+	gilbert_locate(&it->root, data->dimension, d, &leaf, &start);
+	gilbert_row_point(&leaf, d - start, data->dimension, val);
+}
+
+static int gilbert_it_peek(const_excit_t data, ssize_t *val)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+	ssize_t d;
+	int err = excit_peek(it->range_it, &d);
+
+	if (err)
+		return err;
+	if (val)
+		gilbert_it_d2p(data, d, val);
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Successive points of a row are computed directly, the row of the next point
+ * is only located when leaving it.
+ */
+static int gilbert_it_next(excit_t data, ssize_t *val)
+{
+	struct gilbert_it_s *it = (struct gilbert_it_s *)data->data;
+	ssize_t d;
+	int err = excit_next(it->range_it, &d);
+
+	if (err)
+		return err;
+	if (!val)
+		return EXCIT_SUCCESS;
+	if (d < it->leaf_start || d >= it->leaf_start + it->leaf_size) {
+		gilbert_locate(&it->root, data->dimension, d, &it->leaf,
+			       &it->leaf_start);
+		it->leaf_size = box_size(&it->leaf);
+	}
+	gilbert_row_point(&it->leaf, d - it->leaf_start, data->dimension, val);
+	return EXCIT_SUCCESS;
+}
+
+static int gilbert_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+
+	return excit_size(it->range_it, size);
+}
+
+static int gilbert_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+	ssize_t d;
+	int err = excit_nth(it->range_it, n, &d);
+
+	if (err)
+		return err;
+	if (val)
+		gilbert_it_d2p(data, d, val);
+	return EXCIT_SUCCESS;
+}
+
+static int gilbert_it_rank(const_excit_t data, const ssize_t *indexes,
+			   ssize_t *n)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+	ssize_t val[3] = { 0, 0, 0 };
+	ssize_t d;
+
+	for (ssize_t i = 0; i < data->dimension; i++)
+		val[i] = indexes[i];
+	if (!gilbert_box_contains(&it->root, val))
+		return -EXCIT_EINVAL;
+	d = gilbert_rank(&it->root, data->dimension, val);
+	return excit_rank(it->range_it, &d, n);
+}
+
+static int gilbert_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+
+	return excit_pos(it->range_it, n);
+}
+
+static int gilbert_it_seek(excit_t data, ssize_t rank)
+{
+	struct gilbert_it_s *it = (struct gilbert_it_s *)data->data;
+
+	return excit_seek(it->range_it, rank);
+}
+
+static int gilbert_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct gilbert_it_s *it =
+	    (const struct gilbert_it_s *)data->data;
+	int err = excit_split(it->range_it, n, results);
+
+	if (err)
+		return err;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (int i = 0; i < n; i++) {
+		excit_t tmp;
+
+		tmp = results[i];
+		results[i] = excit_alloc(EXCIT_GILBERT);
+		if (!results[i]) {
+			excit_free(tmp);
+			err = -EXCIT_ENOMEM;
+			goto error;
+		}
+		results[i]->dimension = data->dimension;
+		struct gilbert_it_s *res_it =
+		    (struct gilbert_it_s *)results[i]->data;
+		res_it->range_it = tmp;
+		res_it->root = it->root;
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (int i = 0; i < n; i++)
+		excit_free(results[i]);
+	return err;
+}
+
+int excit_gilbert_init(excit_t it, ssize_t dim, const ssize_t *sizes)
+{
+	struct gilbert_it_s *gilbert_it;
+	ssize_t p[3] = { 0, 0, 0 }, v[3][3] = { { 0 } };
+	ssize_t ext[3] = { 1, 1, 1 }, major = 0, total = 1;
+	int err;
+
+	if (!it || it->type != EXCIT_GILBERT || (dim != 2 && dim != 3)
+	    || !sizes)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; i < dim; i++) {
+		if (sizes[i] <= 0)
+			return -EXCIT_EINVAL;
+		if (total > PTRDIFF_MAX / sizes[i])
+			return -EXCIT_EDOM;
+		total *= sizes[i];
+		ext[i] = sizes[i];
+		if (sizes[i] > sizes[major])
+			major = i;
+	}
+	/* the curve starts along the largest extent, other axes in order */
+	for (ssize_t i = 0, j = 1; i < 3; i++) {
+		ssize_t k = i == major ? 0 : j++;
+
+		v[k][i] = ext[i];
+	}
+	gilbert_it = (struct gilbert_it_s *)it->data;
+	excit_free(gilbert_it->range_it);
+	gilbert_it->range_it = excit_alloc(EXCIT_RANGE);
+	if (!gilbert_it->range_it)
+		return -EXCIT_ENOMEM;
+	err = excit_range_init(gilbert_it->range_it, 0, total - 1, 1);
+	if (err)
+		return err;
+	box_set(&gilbert_it->root, p, v[0], v[1], v[2]);
+	gilbert_it->leaf_start = 0;
+	gilbert_it->leaf_size = 0;
+	it->dimension = dim;
+	return EXCIT_SUCCESS;
+}
+
+struct excit_func_table_s excit_gilbert_func_table = {
+	gilbert_it_alloc,
+	gilbert_it_free,
+	gilbert_it_copy,
+	gilbert_it_next,
+	gilbert_it_peek,
+	gilbert_it_size,
+	gilbert_it_rewind,
+	gilbert_it_split,
+	gilbert_it_nth,
+	gilbert_it_rank,
+	gilbert_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	gilbert_it_seek,
+	NULL,
+	NULL
+};
@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_GILBERT_H
+#define EXCIT_GILBERT_H
+
+#include "excit.h"
+
+/*
+ * A box of the curve: its first point p, and three axis aligned vectors
+ * spanning it. The curve enters the box at p and leaves it at the far end of
+ * v[0].
+ */
+struct gilbert_box_s {
+	ssize_t p[3];
+	ssize_t v[3][3];
+};
+
+struct gilbert_it_s {
+	excit_t range_it;
+	struct gilbert_box_s root;
+	/* Last row of the curve visited, and the curve index it starts at */
+	struct gilbert_box_s leaf;
+	ssize_t leaf_start;
+	ssize_t leaf_size;
+};
+
+extern struct excit_func_table_s excit_gilbert_func_table;
+
+#endif //EXCIT_GILBERT_H
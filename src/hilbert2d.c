@@ -7,65 +7,234 @@
  *
  * SPDX-License-Identifier: BSD-3-Clause
  ******************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
 #include "dev/excit.h"
 #include "hilbert2d.h"
 
-/* Helper functions from: https://en.wikipedia.org/wiki/Hilbert_curve */
+/*
+ * The curve is decoded HILBERT2D_CHUNK levels at a time, from the most
+ * significant ones. Each level is a quadrant digit q of the curve index, at
+ * (0,0), (0,1), (1,1) or (1,0) in its parent, and transforms the points of its
+ * quadrant: digit 0 swaps x and y, digit 3 swaps and mirrors them. These
+ * transforms commute, so the orientation of a chunk is the XOR of the
+ * transforms of the levels above it: bit 0 swaps, bit 1 mirrors.
+ *
+ * hilbert2d_d2xy_table maps the digits of a chunk to the coordinates of their
+ * point in an unoriented chunk (x in bits 0-3, y in bits 4-7) and to the XOR
+ * of their transforms (bits 8-9). hilbert2d_xy2d_table is its inverse.
+ */
+#define HILBERT2D_CHUNK 4
+
+static const uint16_t hilbert2d_d2xy_table[256] = {
+	0x000, 0x101, 0x111, 0x210, 0x120, 0x030, 0x031, 0x321,
+	0x122, 0x032, 0x033, 0x323, 0x213, 0x312, 0x302, 0x003,
+	0x104, 0x014, 0x015, 0x305, 0x006, 0x107, 0x117, 0x216,
+	0x026, 0x127, 0x137, 0x236, 0x335, 0x225, 0x224, 0x134,
+	0x144, 0x054, 0x055, 0x345, 0x046, 0x147, 0x157, 0x256,
+	0x066, 0x167, 0x177, 0x276, 0x375, 0x265, 0x264, 0x174,
+	0x273, 0x372, 0x362, 0x063, 0x353, 0x243, 0x242, 0x152,
+	0x351, 0x241, 0x240, 0x150, 0x060, 0x161, 0x171, 0x270,
+	0x180, 0x090, 0x091, 0x381, 0x082, 0x183, 0x193, 0x292,
+	0x0a2, 0x1a3, 0x1b3, 0x2b2, 0x3b1, 0x2a1, 0x2a0, 0x1b0,
+	0x0c0, 0x1c1, 0x1d1, 0x2d0, 0x1e0, 0x0f0, 0x0f1, 0x3e1,
+	0x1e2, 0x0f2, 0x0f3, 0x3e3, 0x2d3, 0x3d2, 0x3c2, 0x0c3,
+	0x0c4, 0x1c5, 0x1d5, 0x2d4, 0x1e4, 0x0f4, 0x0f5, 0x3e5,
+	0x1e6, 0x0f6, 0x0f7, 0x3e7, 0x2d7, 0x3d6, 0x3c6, 0x0c7,
+	0x3b7, 0x2a7, 0x2a6, 0x1b6, 0x2b5, 0x3b4, 0x3a4, 0x0a5,
+	0x295, 0x394, 0x384, 0x085, 0x186, 0x096, 0x097, 0x387,
+	0x188, 0x098, 0x099, 0x389, 0x08a, 0x18b, 0x19b, 0x29a,
+	0x0aa, 0x1ab, 0x1bb, 0x2ba, 0x3b9, 0x2a9, 0x2a8, 0x1b8,
+	0x0c8, 0x1c9, 0x1d9, 0x2d8, 0x1e8, 0x0f8, 0x0f9, 0x3e9,
+	0x1ea, 0x0fa, 0x0fb, 0x3eb, 0x2db, 0x3da, 0x3ca, 0x0cb,
+	0x0cc, 0x1cd, 0x1dd, 0x2dc, 0x1ec, 0x0fc, 0x0fd, 0x3ed,
+	0x1ee, 0x0fe, 0x0ff, 0x3ef, 0x2df, 0x3de, 0x3ce, 0x0cf,
+	0x3bf, 0x2af, 0x2ae, 0x1be, 0x2bd, 0x3bc, 0x3ac, 0x0ad,
+	0x29d, 0x39c, 0x38c, 0x08d, 0x18e, 0x09e, 0x09f, 0x38f,
+	0x27f, 0x37e, 0x36e, 0x06f, 0x35f, 0x24f, 0x24e, 0x15e,
+	0x35d, 0x24d, 0x24c, 0x15c, 0x06c, 0x16d, 0x17d, 0x27c,
+	0x37b, 0x26b, 0x26a, 0x17a, 0x279, 0x378, 0x368, 0x069,
+	0x259, 0x358, 0x348, 0x049, 0x14a, 0x05a, 0x05b, 0x34b,
+	0x33b, 0x22b, 0x22a, 0x13a, 0x239, 0x338, 0x328, 0x029,
+	0x219, 0x318, 0x308, 0x009, 0x10a, 0x01a, 0x01b, 0x30b,
+	0x00c, 0x10d, 0x11d, 0x21c, 0x12c, 0x03c, 0x03d, 0x32d,
+	0x12e, 0x03e, 0x03f, 0x32f, 0x21f, 0x31e, 0x30e, 0x00f,
+};
+static const uint16_t hilbert2d_xy2d_table[256] = {
+	0x000, 0x101, 0x30e, 0x00f, 0x110, 0x313, 0x014, 0x115,
+	0x3ea, 0x0eb, 0x1ec, 0x3ef, 0x0f0, 0x1f1, 0x3fe, 0x0ff,
+	0x203, 0x102, 0x30d, 0x20c, 0x011, 0x012, 0x217, 0x116,
+	0x3e9, 0x2e8, 0x0ed, 0x0ee, 0x2f3, 0x1f2, 0x3fd, 0x2fc,
+	0x104, 0x307, 0x108, 0x30b, 0x21e, 0x21d, 0x018, 0x119,
+	0x3e6, 0x0e7, 0x2e2, 0x2e1, 0x1f4, 0x3f7, 0x1f8, 0x3fb,
+	0x005, 0x006, 0x009, 0x00a, 0x11f, 0x31c, 0x21b, 0x11a,
+	0x3e5, 0x2e4, 0x1e3, 0x3e0, 0x0f5, 0x0f6, 0x0f9, 0x0fa,
+	0x23a, 0x239, 0x236, 0x235, 0x120, 0x323, 0x024, 0x125,
+	0x3da, 0x0db, 0x1dc, 0x3df, 0x2ca, 0x2c9, 0x2c6, 0x2c5,
+	0x13b, 0x338, 0x137, 0x334, 0x021, 0x022, 0x227, 0x126,
+	0x3d9, 0x2d8, 0x0dd, 0x0de, 0x1cb, 0x3c8, 0x1c7, 0x3c4,
+	0x03c, 0x13d, 0x332, 0x033, 0x22e, 0x22d, 0x028, 0x129,
+	0x3d6, 0x0d7, 0x2d2, 0x2d1, 0x0cc, 0x1cd, 0x3c2, 0x0c3,
+	0x23f, 0x13e, 0x331, 0x230, 0x12f, 0x32c, 0x22b, 0x12a,
+	0x3d5, 0x2d4, 0x1d3, 0x3d0, 0x2cf, 0x1ce, 0x3c1, 0x2c0,
+	0x140, 0x343, 0x044, 0x145, 0x37a, 0x07b, 0x17c, 0x37f,
+	0x180, 0x383, 0x084, 0x185, 0x3ba, 0x0bb, 0x1bc, 0x3bf,
+	0x041, 0x042, 0x247, 0x146, 0x379, 0x278, 0x07d, 0x07e,
+	0x081, 0x082, 0x287, 0x186, 0x3b9, 0x2b8, 0x0bd, 0x0be,
+	0x24e, 0x24d, 0x048, 0x149, 0x376, 0x077, 0x272, 0x271,
+	0x28e, 0x28d, 0x088, 0x189, 0x3b6, 0x0b7, 0x2b2, 0x2b1,
+	0x14f, 0x34c, 0x24b, 0x14a, 0x375, 0x274, 0x173, 0x370,
+	0x18f, 0x38c, 0x28b, 0x18a, 0x3b5, 0x2b4, 0x1b3, 0x3b0,
+	0x050, 0x151, 0x35e, 0x05f, 0x060, 0x161, 0x36e, 0x06f,
+	0x090, 0x191, 0x39e, 0x09f, 0x0a0, 0x1a1, 0x3ae, 0x0af,
+	0x253, 0x152, 0x35d, 0x25c, 0x263, 0x162, 0x36d, 0x26c,
+	0x293, 0x192, 0x39d, 0x29c, 0x2a3, 0x1a2, 0x3ad, 0x2ac,
+	0x154, 0x357, 0x158, 0x35b, 0x164, 0x367, 0x168, 0x36b,
+	0x194, 0x397, 0x198, 0x39b, 0x1a4, 0x3a7, 0x1a8, 0x3ab,
+	0x055, 0x056, 0x059, 0x05a, 0x065, 0x066, 0x069, 0x06a,
+	0x095, 0x096, 0x099, 0x09a, 0x0a5, 0x0a6, 0x0a9, 0x0aa,
+};
 
-//rotate/flip a quadrant appropriately
-static void rot(ssize_t n, ssize_t *x, ssize_t *y, ssize_t rx, ssize_t ry)
+/*
+ * Quadrant transform of a digit, see rot() from
+ * https://en.wikipedia.org/wiki/Hilbert_curve
+ */
+static inline int quadrant_orient(ssize_t q)
 {
-	if (ry == 0) {
-		if (rx == 1) {
-			*x = n - 1 - *x;
-			*y = n - 1 - *y;
-		}
-		//Swap x and y
-		ssize_t t = *x;
+	return q == 0 ? 1 : (q == 3 ? 3 : 0);
+}
 
-		*x = *y;
-		*y = t;
-	}
+/* Applies an orientation to chunk coordinates, without branches */
+static inline void chunk_orient(int orient, ssize_t *u, ssize_t *v)
+{
+	ssize_t swap = (*u ^ *v) & -(ssize_t)(orient & 1);
+	ssize_t mirror = -(ssize_t)(orient >> 1) & 0xf;
+
+	*u ^= swap ^ mirror;
+	*v ^= swap ^ mirror;
 }
 
-//convert (x,y) to d
-static ssize_t xy2d(ssize_t n, ssize_t x, ssize_t y)
+/*
+ * Levels are padded to a multiple of the chunk size with 0 digits, whose swaps
+ * are canceled by the initial orientation. Returns the XOR of the transforms
+ * of the digits of d.
+ */
+static inline int d2xy(ssize_t order, ssize_t d, ssize_t *x, ssize_t *y)
 {
-	ssize_t rx, ry, s, d = 0;
+	ssize_t levels = (order + HILBERT2D_CHUNK - 1) & ~(HILBERT2D_CHUNK - 1);
+	int orient = (levels - order) & 1;
 
-	for (s = n / 2; s > 0; s /= 2) {
-		rx = (x & s) > 0;
-		ry = (y & s) > 0;
-		d += s * s * ((3 * rx) ^ ry);
-		rot(s, &x, &y, rx, ry);
+	*x = *y = 0;
+	for (ssize_t l = levels - HILBERT2D_CHUNK; l >= 0;
+	     l -= HILBERT2D_CHUNK) {
+		unsigned int e = hilbert2d_d2xy_table[(d >> (2 * l)) & 0xff];
+		ssize_t u = e & 0xf, v = (e >> 4) & 0xf;
+
+		chunk_orient(orient, &u, &v);
+		*x |= u << l;
+		*y |= v << l;
+		orient ^= e >> 8;
+	}
+	return orient;
+}
+
+static inline ssize_t xy2d(ssize_t order, ssize_t x, ssize_t y)
+{
+	ssize_t levels = (order + HILBERT2D_CHUNK - 1) & ~(HILBERT2D_CHUNK - 1);
+	int orient = (levels - order) & 1;
+	ssize_t d = 0;
+
+	for (ssize_t l = levels - HILBERT2D_CHUNK; l >= 0;
+	     l -= HILBERT2D_CHUNK) {
+		ssize_t u = (x >> l) & 0xf, v = (y >> l) & 0xf;
+		unsigned int e;
+
+		/* orientations are their own inverse */
+		chunk_orient(orient, &u, &v);
+		e = hilbert2d_xy2d_table[u | (v << 4)];
+		d |= (ssize_t)(e & 0xff) << (2 * l);
+		orient ^= e >> 8;
 	}
 	return d;
 }
 
-//convert d to (x,y)
-static void d2xy(ssize_t n, ssize_t d, ssize_t *x, ssize_t *y)
+/*
+ * Curves of at most HILBERT2D_CHUNK levels fit in a single chunk, converted
+ * with a single lookup.
+ */
+static inline void d2xy_chunk(ssize_t order, ssize_t d, ssize_t *x,
+			      ssize_t *y)
 {
-	ssize_t rx, ry, s, t = d;
+	unsigned int e = hilbert2d_d2xy_table[d];
 
-	*x = *y = 0;
-	for (s = 1; s < n; s *= 2) {
-		rx = 1 & (t / 2);
-		ry = 1 & (t ^ rx);
-		rot(s, x, y, rx, ry);
-		*x += s * rx;
-		*y += s * ry;
-		t /= 4;
-	}
+	*x = e & 0xf;
+	*y = (e >> 4) & 0xf;
+	chunk_orient((HILBERT2D_CHUNK - order) & 1, x, y);
+}
+
+static inline ssize_t xy2d_chunk(ssize_t order, ssize_t x, ssize_t y)
+{
+	chunk_orient((HILBERT2D_CHUNK - order) & 1, &x, &y);
+	return hilbert2d_xy2d_table[x | (y << 4)] & 0xff;
+}
+
+static void hilbert2d_locate(ssize_t order, ssize_t d,
+			     struct hilbert2d_pos_s *pos)
+{
+	pos->d = d;
+	pos->orient = d2xy(order, d, pos->xy, pos->xy + 1);
 }
 
-/* End helper functions */
+/*
+ * Moves pos to curve index d. Moving to the next index only looks at the
+ * trailing quadrant digits equal to 3, which is amortized O(1): the step
+ * happens between quadrants q and q + 1 of the first other level k, and
+ * is a unit step whose direction is given by the transforms of the levels
+ * above k.
+ */
+static void hilbert2d_walk(ssize_t order, ssize_t d,
+			   struct hilbert2d_pos_s *pos)
+{
+	ssize_t t = pos->d, k = 0, q, dx, dy, tmp;
+	int orient;
+
+	if (d == t)
+		return;
+	if (d != t + 1) {
+		hilbert2d_locate(order, d, pos);
+		return;
+	}
+	for (; (t & 3) == 3; t /= 4)
+		k++;
+	q = t & 3;
+	/* levels below k have digit 3 before the step and 0 after */
+	orient = pos->orient ^ quadrant_orient(q) ^ (k & 1 ? 3 : 0);
+	pos->orient = orient ^ quadrant_orient(q + 1) ^ (k & 1 ? 1 : 0);
+	/* quadrants 0, 1, 2, 3 are at (0,0), (0,1), (1,1), (1,0) */
+	dx = q == 1;
+	dy = q == 0 ? 1 : (q == 2 ? -1 : 0);
+	if (orient & 1) {
+		tmp = dx;
+		dx = dy;
+		dy = tmp;
+	}
+	if (orient & 2) {
+		dx = -dx;
+		dy = -dy;
+	}
+	pos->xy[0] += dx;
+	pos->xy[1] += dy;
+	pos->d = d;
+}
 
 static int hilbert2d_it_alloc(excit_t data)
 {
 	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
 
 	it->n = 0;
+	it->order = 0;
 	it->range_it = NULL;
+	hilbert2d_locate(0, 0, &it->pos);
 	return EXCIT_SUCCESS;
 }
 
@@ -87,6 +256,8 @@ static int hilbert2d_it_copy(excit_t ddst, const_excit_t dsrc)
 		return -EXCIT_EINVAL;
 	dst->range_it = copy;
 	dst->n = src->n;
+	dst->order = src->order;
+	dst->pos = src->pos;
 	return EXCIT_SUCCESS;
 }
 
@@ -99,19 +270,24 @@ static int hilbert2d_it_rewind(excit_t data)
 
 static int hilbert2d_it_peek(const_excit_t data, ssize_t *val)
 {
-	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
+	struct hilbert2d_pos_s pos = it->pos;
 	ssize_t d;
 	int err;
 
 	err = excit_peek(it->range_it, &d);
 	if (err)
 		return err;
-	if (val)
-		d2xy(it->n, d, val, val + 1);
+	if (val) {
+		hilbert2d_walk(it->order, d, &pos);
+		val[0] = pos.xy[0];
+		val[1] = pos.xy[1];
+	}
 	return EXCIT_SUCCESS;
 }
 
-static int hilbert2d_it_next(excit_t data, ssize_t *val)
+static int hilbert2d_it_next_ref(excit_t data, const ssize_t **tuple)
 {
 	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
 	ssize_t d;
@@ -119,8 +295,44 @@ static int hilbert2d_it_next(excit_t data, ssize_t *val)
 
 	if (err)
 		return err;
-	if (val)
-		d2xy(it->n, d, val, val + 1);
+	hilbert2d_walk(it->order, d, &it->pos);
+	*tuple = it->pos.xy;
+	return EXCIT_SUCCESS;
+}
+
+static int hilbert2d_it_next(excit_t data, ssize_t *val)
+{
+	const ssize_t *xy;
+	int err = hilbert2d_it_next_ref(data, &xy);
+
+	if (err)
+		return err;
+	if (val) {
+		val[0] = xy[0];
+		val[1] = xy[1];
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int hilbert2d_it_next_batch(excit_t data, ssize_t max, ssize_t *val,
+				   ssize_t *produced)
+{
+	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	ssize_t count;
+	/* curve indexes are staged in the upper half of the output buffer */
+	int err = excit_next_batch(it->range_it, max, val ? val + max : NULL,
+				   &count);
+
+	if (err)
+		return err;
+	if (val) {
+		for (ssize_t i = 0; i < count; i++) {
+			hilbert2d_walk(it->order, val[max + i], &it->pos);
+			val[2 * i] = it->pos.xy[0];
+			val[2 * i + 1] = it->pos.xy[1];
+		}
+	}
+	*produced = count;
 	return EXCIT_SUCCESS;
 }
 
@@ -133,36 +345,162 @@ static int hilbert2d_it_size(const_excit_t data, ssize_t *size)
 static int hilbert2d_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
 {
 	ssize_t d;
-	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
 	int err = excit_nth(it->range_it, n, &d);
 
 	if (err)
 		return err;
 	if (val)
-		d2xy(it->n, d, val, val + 1);
+		d2xy(it->order, d, val, val + 1);
 	return EXCIT_SUCCESS;
 }
 
 static int hilbert2d_it_rank(const_excit_t data, const ssize_t *indexes,
 			     ssize_t *n)
 {
-	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
+
+	if (indexes[0] < 0 || indexes[0] >= it->n || indexes[1] < 0
+	    || indexes[1] >= it->n)
+		return -EXCIT_EINVAL;
+	ssize_t d = xy2d(it->order, indexes[0], indexes[1]);
+
+	return excit_rank(it->range_it, &d, n);
+}
+
+static int hilbert2d_it_nth_batch(const_excit_t data, ssize_t count,
+				  const ssize_t *ranks, ssize_t *val)
+{
+	const struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	/* curve indexes are staged in the upper half of the output buffer */
+	int err = excit_nth_batch(it->range_it, count, ranks,
+				  val ? val + count : NULL);
+
+	if (err)
+		return err;
+	if (val)
+		for (ssize_t i = 0; i < count; i++)
+			d2xy(it->order, val[count + i], val + 2 * i,
+			     val + 2 * i + 1);
+	return EXCIT_SUCCESS;
+}
+
+static int hilbert2d_it_rank_batch(const_excit_t data, ssize_t count,
+				   const ssize_t *indexes, ssize_t *ranks)
+{
+	const struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	ssize_t *d = malloc(count * sizeof(ssize_t));
+	int err;
+
+	if (!d)
+		return -EXCIT_ENOMEM;
+	for (ssize_t i = 0; i < count; i++) {
+		ssize_t x = indexes[2 * i];
+		ssize_t y = indexes[2 * i + 1];
+
+		if (x < 0 || x >= it->n || y < 0 || y >= it->n) {
+			err = -EXCIT_EINVAL;
+			goto exit;
+		}
+	}
+	/* checked apart so that the conversion loop has no branches */
+	for (ssize_t i = 0; i < count; i++)
+		d[i] = xy2d(it->order, indexes[2 * i], indexes[2 * i + 1]);
+	err = excit_rank_batch(it->range_it, count, d, ranks);
+exit:
+	free(d);
+	return err;
+}
+
+static int hilbert2d_chunk_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
+{
+	ssize_t d;
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
+	int err = excit_nth(it->range_it, n, &d);
+
+	if (err)
+		return err;
+	if (val)
+		d2xy_chunk(it->order, d, val, val + 1);
+	return EXCIT_SUCCESS;
+}
+
+static int hilbert2d_chunk_it_rank(const_excit_t data, const ssize_t *indexes,
+				   ssize_t *n)
+{
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
 
 	if (indexes[0] < 0 || indexes[0] >= it->n || indexes[1] < 0
 	    || indexes[1] >= it->n)
 		return -EXCIT_EINVAL;
-	ssize_t d = xy2d(it->n, indexes[0], indexes[1]);
+	ssize_t d = xy2d_chunk(it->order, indexes[0], indexes[1]);
 
 	return excit_rank(it->range_it, &d, n);
 }
 
+static int hilbert2d_chunk_it_nth_batch(const_excit_t data, ssize_t count,
+					const ssize_t *ranks, ssize_t *val)
+{
+	const struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	int err = excit_nth_batch(it->range_it, count, ranks,
+				  val ? val + count : NULL);
+
+	if (err)
+		return err;
+	if (val)
+		for (ssize_t i = 0; i < count; i++)
+			d2xy_chunk(it->order, val[count + i], val + 2 * i,
+				   val + 2 * i + 1);
+	return EXCIT_SUCCESS;
+}
+
+static int hilbert2d_chunk_it_rank_batch(const_excit_t data, ssize_t count,
+					 const ssize_t *indexes,
+					 ssize_t *ranks)
+{
+	const struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	ssize_t *d = malloc(count * sizeof(ssize_t));
+	int err;
+
+	if (!d)
+		return -EXCIT_ENOMEM;
+	for (ssize_t i = 0; i < count; i++) {
+		ssize_t x = indexes[2 * i];
+		ssize_t y = indexes[2 * i + 1];
+
+		if (x < 0 || x >= it->n || y < 0 || y >= it->n) {
+			err = -EXCIT_EINVAL;
+			goto exit;
+		}
+	}
+	for (ssize_t i = 0; i < count; i++)
+		d[i] = xy2d_chunk(it->order, indexes[2 * i],
+				  indexes[2 * i + 1]);
+	err = excit_rank_batch(it->range_it, count, d, ranks);
+exit:
+	free(d);
+	return err;
+}
+
 static int hilbert2d_it_pos(const_excit_t data, ssize_t *n)
 {
-	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+	const struct hilbert2d_it_s *it =
+	    (const struct hilbert2d_it_s *)data->data;
 
 	return excit_pos(it->range_it, n);
 }
 
+static int hilbert2d_it_seek(excit_t data, ssize_t rank)
+{
+	struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
+
+	return excit_seek(it->range_it, rank);
+}
+
 static int hilbert2d_it_split(const_excit_t data, ssize_t n, excit_t *results)
 {
 	const struct hilbert2d_it_s *it = (struct hilbert2d_it_s *)data->data;
@@ -182,11 +520,14 @@ static int hilbert2d_it_split(const_excit_t data, ssize_t n, excit_t *results)
 			err = -EXCIT_ENOMEM;
 			goto error;
 		}
+		results[i]->func_table = data->func_table;
 		results[i]->dimension = 2;
 		struct hilbert2d_it_s *res_it =
 		    (struct hilbert2d_it_s *)results[i]->data;
 		res_it->n = it->n;
+		res_it->order = it->order;
 		res_it->range_it = tmp;
+		hilbert2d_locate(it->order, 0, &res_it->pos);
 	}
 	return EXCIT_SUCCESS;
 error:
@@ -212,6 +553,10 @@ int excit_hilbert2d_init(excit_t it, ssize_t order)
 	if (err)
 		return err;
 	hilbert2d_it->n = n;
+	hilbert2d_it->order = order;
+	hilbert2d_locate(order, 0, &hilbert2d_it->pos);
+	it->func_table = order <= HILBERT2D_CHUNK ?
+	    &excit_hilbert2d_chunk_func_table : &excit_hilbert2d_func_table;
 	return EXCIT_SUCCESS;
 }
 
@@ -226,6 +571,31 @@ struct excit_func_table_s excit_hilbert2d_func_table = {
 	hilbert2d_it_split,
 	hilbert2d_it_nth,
 	hilbert2d_it_rank,
-	hilbert2d_it_pos
+	hilbert2d_it_pos,
+	hilbert2d_it_next_batch,
+	hilbert2d_it_nth_batch,
+	hilbert2d_it_rank_batch,
+	hilbert2d_it_seek,
+	hilbert2d_it_next_ref,
+	NULL
 };
 
+struct excit_func_table_s excit_hilbert2d_chunk_func_table = {
+	hilbert2d_it_alloc,
+	hilbert2d_it_free,
+	hilbert2d_it_copy,
+	hilbert2d_it_next,
+	hilbert2d_it_peek,
+	hilbert2d_it_size,
+	hilbert2d_it_rewind,
+	hilbert2d_it_split,
+	hilbert2d_chunk_it_nth,
+	hilbert2d_chunk_it_rank,
+	hilbert2d_it_pos,
+	hilbert2d_it_next_batch,
+	hilbert2d_chunk_it_nth_batch,
+	hilbert2d_chunk_it_rank_batch,
+	hilbert2d_it_seek,
+	hilbert2d_it_next_ref,
+	NULL
+};
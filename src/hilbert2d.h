@@ -12,12 +12,31 @@
 
 #include "excit.h"
 
+/* A point of the curve, used to walk it incrementally */
+struct hilbert2d_pos_s {
+	/* Curve index */
+	ssize_t d;
+	/* Coordinates of the point */
+	ssize_t xy[2];
+	/*
+	 * XOR of the transforms of every quadrant digit of d:
+	 * bit 0 swaps x and y, bit 1 mirrors both.
+	 */
+	int orient;
+};
+
 struct hilbert2d_it_s {
 	ssize_t n;
+	/* log2(n) */
+	ssize_t order;
 	excit_t range_it;
+	/* Last point returned */
+	struct hilbert2d_pos_s pos;
 };
 
 extern struct excit_func_table_s excit_hilbert2d_func_table;
+/* Curves of at most 4 levels */
+extern struct excit_func_table_s excit_hilbert2d_chunk_func_table;
 
 #endif //EXCIT_HILBERT2D_H
 
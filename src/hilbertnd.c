@@ -0,0 +1,412 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "hilbertnd.h"
+
+/*
+ * Helper functions from: C. Hamilton, "Compact Hilbert Indices", 2006.
+ * A curve index is made of one digit of dim bits per level, from the most
+ * significant. Each level is interpreted in the frame of its sub-cube, given
+ * by an entry point and a direction computed from the digits above it.
+ */
+
+static inline size_t mask(ssize_t n)
+{
+	return n >= (ssize_t)(8 * sizeof(size_t)) ? ~(size_t)0 :
+	    ((size_t)1 << n) - 1;
+}
+
+static inline size_t rotl(size_t x, ssize_t r, ssize_t n)
+{
+	r %= n;
+	if (!r)
+		return x;
+	return ((x << r) | (x >> (n - r))) & mask(n);
+}
+
+static inline size_t rotr(size_t x, ssize_t r, ssize_t n)
+{
+	return rotl(x, n - r % n, n);
+}
+
+static inline size_t gc(size_t w)
+{
+	return w ^ (w >> 1);
+}
+
+static inline size_t gcinv(size_t g)
+{
+	for (size_t s = 1; s < 8 * sizeof(size_t); s <<= 1)
+		g ^= g >> s;
+	return g;
+}
+
+//number of trailing set bits
+static inline ssize_t tsb(size_t w)
+{
+	ssize_t c = 0;
+
+	for (; w & 1; w >>= 1)
+		c++;
+	return c;
+}
+
+//frame of the sub-cube of digit w, in a cube of frame (*e, *d)
+static inline void frame_update(size_t *e, ssize_t *d, size_t w, ssize_t n)
+{
+	size_t entry = w == 0 ? 0 : gc(2 * ((w - 1) / 2));
+	ssize_t dir = w == 0 ? 0 : (w & 1 ? tsb(w) : tsb(w - 1)) % n;
+
+	*e ^= rotl(entry, *d + 1, n);
+	*d = (*d + dir + 1) % n;
+}
+
+//convert h to coordinates
+static void h2p(ssize_t n, ssize_t order, ssize_t h, ssize_t *p)
+{
+	size_t e = 0;
+	ssize_t d = 0;
+
+	memset(p, 0, n * sizeof(ssize_t));
+	for (ssize_t i = order - 1; i >= 0; i--) {
+		size_t w = ((size_t)h >> (i * n)) & mask(n);
+		size_t l = rotl(gc(w), d + 1, n) ^ e;
+
+		for (ssize_t j = 0; j < n; j++)
+			p[j] |= (ssize_t)((l >> j) & 1) << i;
+		frame_update(&e, &d, w, n);
+	}
+}
+
+//convert coordinates to h
+static ssize_t p2h(ssize_t n, ssize_t order, const ssize_t *p)
+{
+	size_t e = 0, h = 0;
+	ssize_t d = 0;
+
+	for (ssize_t i = order - 1; i >= 0; i--) {
+		size_t l = 0, w;
+
+		for (ssize_t j = 0; j < n; j++)
+			l |= (((size_t)p[j] >> i) & 1) << j;
+		w = gcinv(rotr(l ^ e, d + 1, n));
+		frame_update(&e, &d, w, n);
+		h = (h << n) | w;
+	}
+	return h;
+}
+
+/* End helper functions */
+
+/* Sets the point and the frames of every level to those of index h */
+static void hilbertnd_it_locate(excit_t data, ssize_t h)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+	ssize_t n = data->dimension;
+
+	it->h = h;
+	h2p(n, it->order, h, it->coords);
+	it->entries[it->order - 1] = 0;
+	it->dirs[it->order - 1] = 0;
+	for (ssize_t i = it->order - 1; i > 0; i--) {
+		it->entries[i - 1] = it->entries[i];
+		it->dirs[i - 1] = it->dirs[i];
+		frame_update(it->entries + i - 1, it->dirs + i - 1,
+			     ((size_t)h >> (i * n)) & mask(n), n);
+	}
+}
+
+/*
+ * Moves to curve index h. Moving to the next index is a unit step: if k is the
+ * lowest level whose digit w is not all ones, it happens between the
+ * sub-cubes w and w + 1 of level k, whose gray codes differ on bit tsb(w).
+ * Only the frames of the levels below k are updated, which is amortized O(1).
+ */
+static void hilbertnd_it_walk(excit_t data, ssize_t h)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+	ssize_t n = data->dimension;
+	size_t t = it->h, w, l;
+	ssize_t k = 0, axis;
+
+	if (h == it->h)
+		return;
+	if (h != it->h + 1) {
+		hilbertnd_it_locate(data, h);
+		return;
+	}
+	for (; (t & mask(n)) == mask(n); t >>= n)
+		k++;
+	w = t & mask(n);
+	axis = (tsb(w) + it->dirs[k] + 1) % n;
+	l = rotl(gc(w + 1), it->dirs[k] + 1, n) ^ it->entries[k];
+	it->coords[axis] += (l >> axis) & 1 ? 1 : -1;
+	if (k > 0) {
+		it->entries[k - 1] = it->entries[k];
+		it->dirs[k - 1] = it->dirs[k];
+		frame_update(it->entries + k - 1, it->dirs + k - 1, w + 1, n);
+	}
+	for (ssize_t i = k - 1; i > 0; i--) {
+		it->entries[i - 1] = it->entries[i];
+		it->dirs[i - 1] = it->dirs[i];
+		frame_update(it->entries + i - 1, it->dirs + i - 1, 0, n);
+	}
+	it->h = h;
+}
+
+static int hilbertnd_it_alloc(excit_t data)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+
+	it->order = 0;
+	it->range_it = NULL;
+	it->h = 0;
+	it->coords = NULL;
+	it->entries = NULL;
+	it->dirs = NULL;
+	return EXCIT_SUCCESS;
+}
+
+static void hilbertnd_it_free(excit_t data)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+
+	excit_free(it->range_it);
+	free(it->coords);
+}
+
+/*
+ * Allocates coords, entries and dirs in a single block, for a curve of
+ * dimension dim and order levels.
+ */
+static int hilbertnd_it_alloc_buffers(struct hilbertnd_it_s *it, ssize_t dim,
+				      ssize_t order)
+{
+	ssize_t *buff = malloc((dim + 2 * order) * sizeof(ssize_t));
+
+	if (!buff)
+		return -EXCIT_ENOMEM;
+	free(it->coords);
+	it->coords = buff;
+	it->entries = (size_t *)(buff + dim);
+	it->dirs = buff + dim + order;
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct hilbertnd_it_s *dst = (struct hilbertnd_it_s *)ddst->data;
+	const struct hilbertnd_it_s *src =
+	    (const struct hilbertnd_it_s *)dsrc->data;
+	ssize_t dim = dsrc->dimension;
+	excit_t copy = excit_dup(src->range_it);
+	int err;
+
+	if (!copy)
+		return -EXCIT_EINVAL;
+	err = hilbertnd_it_alloc_buffers(dst, dim, src->order);
+	if (err) {
+		excit_free(copy);
+		return err;
+	}
+	dst->range_it = copy;
+	dst->order = src->order;
+	dst->h = src->h;
+	memcpy(dst->coords, src->coords,
+	       (dim + 2 * src->order) * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_rewind(excit_t data)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+
+	return excit_rewind(it->range_it);
+}
+
+static int hilbertnd_it_peek(const_excit_t data, ssize_t *val)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+	ssize_t h;
+	int err = excit_peek(it->range_it, &h);
+
+	if (err)
+		return err;
+	if (val)
+		h2p(data->dimension, it->order, h, val);
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_next_ref(excit_t data, const ssize_t **tuple)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+	ssize_t h;
+	int err = excit_next(it->range_it, &h);
+
+	if (err)
+		return err;
+	hilbertnd_it_walk(data, h);
+	*tuple = it->coords;
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_next(excit_t data, ssize_t *val)
+{
+	const ssize_t *coords;
+	int err = hilbertnd_it_next_ref(data, &coords);
+
+	if (err)
+		return err;
+	if (val)
+		memcpy(val, coords, data->dimension * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+
+	return excit_size(it->range_it, size);
+}
+
+static int hilbertnd_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+	ssize_t h;
+	int err = excit_nth(it->range_it, n, &h);
+
+	if (err)
+		return err;
+	if (val)
+		h2p(data->dimension, it->order, h, val);
+	return EXCIT_SUCCESS;
+}
+
+static int hilbertnd_it_rank(const_excit_t data, const ssize_t *indexes,
+			     ssize_t *n)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+	ssize_t h;
+
+	for (ssize_t i = 0; i < data->dimension; i++)
+		if (indexes[i] < 0 || indexes[i] >= (ssize_t)1 << it->order)
+			return -EXCIT_EINVAL;
+	h = p2h(data->dimension, it->order, indexes);
+	return excit_rank(it->range_it, &h, n);
+}
+
+static int hilbertnd_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+
+	return excit_pos(it->range_it, n);
+}
+
+static int hilbertnd_it_seek(excit_t data, ssize_t rank)
+{
+	struct hilbertnd_it_s *it = (struct hilbertnd_it_s *)data->data;
+
+	return excit_seek(it->range_it, rank);
+}
+
+static int hilbertnd_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct hilbertnd_it_s *it =
+	    (const struct hilbertnd_it_s *)data->data;
+	int err = excit_split(it->range_it, n, results);
+
+	if (err)
+		return err;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (int i = 0; i < n; i++) {
+		excit_t tmp;
+
+		tmp = results[i];
+		results[i] = excit_alloc(EXCIT_HILBERTND);
+		if (!results[i]) {
+			excit_free(tmp);
+			err = -EXCIT_ENOMEM;
+			goto error;
+		}
+		struct hilbertnd_it_s *res_it =
+		    (struct hilbertnd_it_s *)results[i]->data;
+		err = hilbertnd_it_alloc_buffers(res_it, data->dimension,
+						 it->order);
+		if (err) {
+			excit_free(tmp);
+			goto error;
+		}
+		results[i]->dimension = data->dimension;
+		res_it->order = it->order;
+		res_it->range_it = tmp;
+		hilbertnd_it_locate(results[i], 0);
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (int i = 0; i < n; i++)
+		excit_free(results[i]);
+	return err;
+}
+
+int excit_hilbertnd_init(excit_t it, ssize_t dim, ssize_t order)
+{
+	struct hilbertnd_it_s *hilbertnd_it;
+
+	if (!it || it->type != EXCIT_HILBERTND || dim <= 0 || order <= 0)
+		return -EXCIT_EINVAL;
+	/* the size of the curve must fit in a ssize_t */
+	if (dim * order >= (ssize_t)(8 * sizeof(ssize_t)) - 1)
+		return -EXCIT_EDOM;
+	hilbertnd_it = (struct hilbertnd_it_s *)it->data;
+	int err = hilbertnd_it_alloc_buffers(hilbertnd_it, dim, order);
+
+	if (err)
+		return err;
+	excit_free(hilbertnd_it->range_it);
+	hilbertnd_it->range_it = excit_alloc(EXCIT_RANGE);
+	if (!hilbertnd_it->range_it)
+		return -EXCIT_ENOMEM;
+	err = excit_range_init(hilbertnd_it->range_it, 0,
+			       ((ssize_t)1 << (dim * order)) - 1, 1);
+	if (err)
+		return err;
+	it->dimension = dim;
+	hilbertnd_it->order = order;
+	hilbertnd_it_locate(it, 0);
+	return EXCIT_SUCCESS;
+}
+
+struct excit_func_table_s excit_hilbertnd_func_table = {
+	hilbertnd_it_alloc,
+	hilbertnd_it_free,
+	hilbertnd_it_copy,
+	hilbertnd_it_next,
+	hilbertnd_it_peek,
+	hilbertnd_it_size,
+	hilbertnd_it_rewind,
+	hilbertnd_it_split,
+	hilbertnd_it_nth,
+	hilbertnd_it_rank,
+	hilbertnd_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	hilbertnd_it_seek,
+	hilbertnd_it_next_ref,
+	NULL
+};
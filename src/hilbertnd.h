@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_HILBERTND_H
+#define EXCIT_HILBERTND_H
+
+#include "excit.h"
+
+struct hilbertnd_it_s {
+	ssize_t order;
+	excit_t range_it;
+	/* Last curve index returned */
+	ssize_t h;
+	/* Coordinates of h */
+	ssize_t *coords;
+	/* Entry point and direction of the sub-cube of each level of h */
+	size_t *entries;
+	ssize_t *dirs;
+};
+
+extern struct excit_func_table_s excit_hilbertnd_func_table;
+
+#endif //EXCIT_HILBERTND_H
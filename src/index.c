@@ -96,7 +96,7 @@ static void index_it_free(excit_t it)
 
 static int index_it_size(const_excit_t it, ssize_t *size)
 {
-	struct index_it_s *data_it = it->data;
+	const struct index_it_s *data_it = it->data;
 
 	*size = data_it->len;
 	return EXCIT_SUCCESS;
@@ -118,6 +118,7 @@ static int index_it_copy(excit_t dst_it, const_excit_t src_it)
 
 	dst->pos = src->pos;
 	dst->len = src->len;
+	dst->inversible = src->inversible;
 
 	if (src->len == 0)
 		return EXCIT_SUCCESS;
@@ -142,7 +143,7 @@ static int index_it_pos(const_excit_t it, ssize_t *value)
 	if (value == NULL)
 		return EXCIT_SUCCESS;
 
-	struct index_it_s *data_it = it->data;
+	const struct index_it_s *data_it = it->data;
 	*value = data_it->pos;
 	if (data_it->pos >= data_it->len)
 		return EXCIT_STOPIT;
@@ -151,7 +152,7 @@ static int index_it_pos(const_excit_t it, ssize_t *value)
 
 static int index_it_nth(const_excit_t it, ssize_t n, ssize_t *indexes)
 {
-	struct index_it_s *data_it = it->data;
+	const struct index_it_s *data_it = it->data;
 
 	if (n < 0 || n >= data_it->len)
 		return -EXCIT_EDOM;
@@ -163,7 +164,7 @@ static int index_it_nth(const_excit_t it, ssize_t n, ssize_t *indexes)
 
 static int index_it_peek(const_excit_t it, ssize_t *value)
 {
-	struct index_it_s *data_it = it->data;
+	const struct index_it_s *data_it = it->data;
 
 	if (data_it->pos >= data_it->len)
 		return EXCIT_STOPIT;
@@ -185,9 +186,30 @@ static int index_it_next(excit_t it, ssize_t *indexes)
 	return EXCIT_SUCCESS;
 }
 
-static int index_it_rank(const_excit_t it, const ssize_t *indexes, ssize_t *n)
+static int index_it_next_batch(excit_t it, ssize_t max, ssize_t *indexes,
+			       ssize_t *produced)
 {
 	struct index_it_s *data_it = it->data;
+	ssize_t count = data_it->len - data_it->pos;
+
+	if (count <= 0)
+		return EXCIT_STOPIT;
+	if (count > max)
+		count = max;
+	if (indexes) {
+		const struct index_s *index = data_it->index + data_it->pos;
+
+		for (ssize_t i = 0; i < count; i++)
+			indexes[i] = index[i].value;
+	}
+	data_it->pos += count;
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int index_it_rank(const_excit_t it, const ssize_t *indexes, ssize_t *n)
+{
+	const struct index_it_s *data_it = it->data;
 
 	if (!data_it->inversible)
 		return -EXCIT_ENOTSUP;
@@ -196,11 +218,50 @@ static int index_it_rank(const_excit_t it, const ssize_t *indexes, ssize_t *n)
 		return EXCIT_SUCCESS;
 
 	if (*indexes < data_it->index[0].sorted_value
-	    || *indexes >= data_it->index[data_it->len - 1].sorted_value)
-		return -EXCIT_EDOM;
+	    || *indexes > data_it->index[data_it->len - 1].sorted_value)
+		return -EXCIT_EINVAL;
+
+	ssize_t pos = search_index_pos(*indexes, data_it->len, data_it->index);
 
+	if (pos < 0)
+		return -EXCIT_EINVAL;
 	if (n != NULL)
-		*n = search_index_pos(*indexes, data_it->len, data_it->index);
+		*n = pos;
+	return EXCIT_SUCCESS;
+}
+
+static int index_it_nth_batch(const_excit_t it, ssize_t count,
+			      const ssize_t *ranks, ssize_t *indexes)
+{
+	const struct index_it_s *data_it = it->data;
+
+	for (ssize_t i = 0; i < count; i++)
+		if (ranks[i] < 0 || ranks[i] >= data_it->len)
+			return -EXCIT_EDOM;
+	if (indexes)
+		for (ssize_t i = 0; i < count; i++)
+			indexes[i] = data_it->index[ranks[i]].value;
+	return EXCIT_SUCCESS;
+}
+
+static int index_it_rank_batch(const_excit_t it, ssize_t count,
+			       const ssize_t *indexes, ssize_t *ranks)
+{
+	for (ssize_t i = 0; i < count; i++) {
+		int err = index_it_rank(it, indexes + i, ranks ? ranks + i :
+					NULL);
+
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int index_it_seek(excit_t it, ssize_t rank)
+{
+	struct index_it_s *data_it = it->data;
+
+	data_it->pos = rank;
 	return EXCIT_SUCCESS;
 }
 
@@ -241,5 +302,11 @@ struct excit_func_table_s excit_index_func_table = {
 	NULL,
 	index_it_nth,
 	index_it_rank,
-	index_it_pos
+	index_it_pos,
+	index_it_next_batch,
+	index_it_nth_batch,
+	index_it_rank_batch,
+	index_it_seek,
+	NULL,
+	NULL
 };
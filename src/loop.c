@@ -17,6 +17,8 @@ static int loop_it_alloc(excit_t data)
 	it->it = NULL;
 	it->n = 0;
 	it->counter = 0;
+	it->size = -1;
+	excit_divisor_init(&it->size_div, 1);
 	return EXCIT_SUCCESS;
 }
 
@@ -38,6 +40,8 @@ static int loop_it_copy(excit_t ddst, const_excit_t dsrc)
 	dst->it = copy;
 	dst->n = src->n;
 	dst->counter = src->counter;
+	dst->size = src->size;
+	dst->size_div = src->size_div;
 	return EXCIT_SUCCESS;
 }
 
@@ -83,35 +87,47 @@ static int loop_it_rewind(excit_t data)
 
 static int loop_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
 {
-	ssize_t size;
 	const struct loop_it_s *it = (const struct loop_it_s *)data->data;
-	int err = excit_size(it->it, &size);
 
-	if (err)
-		return err;
-	if (n < 0 || n >= size*it->n)
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
+	if (n < 0 || n >= it->size * it->n)
 		return -EXCIT_EDOM;
 
-	return excit_nth(it->it, n % size, val);
+	return excit_nth(it->it, n - excit_divide(&it->size_div, n) * it->size,
+			 val);
 }
 
 static int loop_it_pos(const_excit_t data, ssize_t *n)
 {
 	ssize_t inner_n;
-	ssize_t size;
 	const struct loop_it_s *it = (const struct loop_it_s *)data->data;
 	int err = excit_pos(it->it, &inner_n);
 
 	if (err)
 		return err;
-	err = excit_size(it->it, &size);
-	if (err)
-		return err;
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
 	if (n)
-		*n = inner_n + it->counter * size;
+		*n = inner_n + it->counter * it->size;
 	return EXCIT_SUCCESS;
 }
 
+static int loop_it_seek(excit_t data, ssize_t rank)
+{
+	struct loop_it_s *it = (struct loop_it_s *)data->data;
+
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
+	/* the last loop does not wrap around, see loop_it_next */
+	if (rank == it->size * it->n) {
+		it->counter = it->n - 1;
+		return excit_seek(it->it, it->size);
+	}
+	it->counter = excit_divide(&it->size_div, rank);
+	return excit_seek(it->it, rank - it->counter * it->size);
+}
+
 struct excit_func_table_s excit_loop_func_table = {
 	loop_it_alloc,
 	loop_it_free,
@@ -123,7 +139,13 @@ struct excit_func_table_s excit_loop_func_table = {
 	NULL,
 	loop_it_nth,
 	NULL,
-	loop_it_pos
+	loop_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	loop_it_seek,
+	NULL,
+	NULL
 };
 
 int excit_loop_init(excit_t it, excit_t src, ssize_t n)
@@ -136,6 +158,10 @@ int excit_loop_init(excit_t it, excit_t src, ssize_t n)
 	loop_it->it = src;
 	loop_it->n = n;
 	loop_it->counter = 0;
+	/* the size of src is fixed, cache it along with its divisor */
+	if (excit_size(src, &loop_it->size))
+		loop_it->size = -1;
+	excit_divisor_init(&loop_it->size_div, loop_it->size);
 	return EXCIT_SUCCESS;
 }
 
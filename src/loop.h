@@ -12,11 +12,15 @@
 
 #include "excit.h"
 #include "dev/excit.h"
+#include "divide.h"
 
 struct loop_it_s {
 	excit_t it;
 	ssize_t n;
 	ssize_t counter;
+	/* Size of it, -1 if it does not support size */
+	ssize_t size;
+	struct excit_divisor_s size_div;
 };
 
 extern struct excit_func_table_s excit_loop_func_table;
@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "morton.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MORTON_BMI2 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Portable bit scatter and gather, one iteration per bit of the mask.
+ */
+static size_t morton_deposit(size_t val, size_t mask)
+{
+	size_t res = 0;
+
+	for (size_t bit = 1; mask; bit <<= 1) {
+		size_t low = mask & -mask;
+
+		if (val & bit)
+			res |= low;
+		mask ^= low;
+	}
+	return res;
+}
+
+static size_t morton_extract(size_t val, size_t mask)
+{
+	size_t res = 0;
+
+	for (size_t bit = 1; mask; bit <<= 1) {
+		size_t low = mask & -mask;
+
+		if (val & low)
+			res |= bit;
+		mask ^= low;
+	}
+	return res;
+}
+
+#ifdef MORTON_BMI2
+__attribute__((target("bmi2")))
+static size_t morton_deposit_bmi2(size_t val, size_t mask)
+{
+	return _pdep_u64(val, mask);
+}
+
+__attribute__((target("bmi2")))
+static size_t morton_extract_bmi2(size_t val, size_t mask)
+{
+	return _pext_u64(val, mask);
+}
+#endif
+
+static inline void morton_it_decode(const struct morton_it_s *it, ssize_t dim,
+				    ssize_t d, ssize_t *val)
+{
+	for (ssize_t i = 0; i < dim; i++)
+		val[i] = it->extract(d, it->masks[i]);
+}
+
+static int morton_it_alloc(excit_t data)
+{
+	struct morton_it_s *it = (struct morton_it_s *)data->data;
+
+	it->range_it = NULL;
+	it->bits = NULL;
+	it->masks = NULL;
+	it->deposit = morton_deposit;
+	it->extract = morton_extract;
+	return EXCIT_SUCCESS;
+}
+
+static void morton_it_free(excit_t data)
+{
+	struct morton_it_s *it = (struct morton_it_s *)data->data;
+
+	excit_free(it->range_it);
+	free(it->bits);
+}
+
+/* Allocates bits and masks in a single block */
+static int morton_it_alloc_buffers(struct morton_it_s *it, ssize_t dim)
+{
+	ssize_t *buff = malloc(2 * dim * sizeof(ssize_t));
+
+	if (!buff)
+		return -EXCIT_ENOMEM;
+	free(it->bits);
+	it->bits = buff;
+	it->masks = (size_t *)(buff + dim);
+	return EXCIT_SUCCESS;
+}
+
+static int morton_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct morton_it_s *dst = (struct morton_it_s *)ddst->data;
+	const struct morton_it_s *src = (const struct morton_it_s *)dsrc->data;
+	excit_t copy = excit_dup(src->range_it);
+	int err;
+
+	if (!copy)
+		return -EXCIT_EINVAL;
+	err = morton_it_alloc_buffers(dst, dsrc->dimension);
+	if (err) {
+		excit_free(copy);
+		return err;
+	}
+	memcpy(dst->bits, src->bits, 2 * dsrc->dimension * sizeof(ssize_t));
+	dst->range_it = copy;
+	dst->deposit = src->deposit;
+	dst->extract = src->extract;
+	return EXCIT_SUCCESS;
+}
+
+static int morton_it_rewind(excit_t data)
+{
+	struct morton_it_s *it = (struct morton_it_s *)data->data;
+
+	return excit_rewind(it->range_it);
+}
+
+static int morton_it_peek(const_excit_t data, ssize_t *val)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+	ssize_t d;
+	int err = excit_peek(it->range_it, &d);
+
+	if (err)
+		return err;
+	if (val)
+		morton_it_decode(it, data->dimension, d, val);
+	return EXCIT_SUCCESS;
+}
+
+static int morton_it_next(excit_t data, ssize_t *val)
+{
+	struct morton_it_s *it = (struct morton_it_s *)data->data;
+	ssize_t d;
+	int err = excit_next(it->range_it, &d);
+
+	if (err)
+		return err;
+	if (val)
+		morton_it_decode(it, data->dimension, d, val);
+	return EXCIT_SUCCESS;
+}
+
+static int morton_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+
+	return excit_size(it->range_it, size);
+}
+
+static int morton_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+	ssize_t d;
+	int err = excit_nth(it->range_it, n, &d);
+
+	if (err)
+		return err;
+	if (val)
+		morton_it_decode(it, data->dimension, d, val);
+	return EXCIT_SUCCESS;
+}
+
+static int morton_it_rank(const_excit_t data, const ssize_t *indexes,
+			  ssize_t *n)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+	ssize_t d = 0;
+
+	for (ssize_t i = 0; i < data->dimension; i++) {
+		if (indexes[i] < 0 || indexes[i] >= (ssize_t)1 << it->bits[i])
+			return -EXCIT_EINVAL;
+		d |= it->deposit(indexes[i], it->masks[i]);
+	}
+	return excit_rank(it->range_it, &d, n);
+}
+
+static int morton_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+
+	return excit_pos(it->range_it, n);
+}
+
+static int morton_it_seek(excit_t data, ssize_t rank)
+{
+	struct morton_it_s *it = (struct morton_it_s *)data->data;
+
+	return excit_seek(it->range_it, rank);
+}
+
+static int morton_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct morton_it_s *it = (const struct morton_it_s *)data->data;
+	int err = excit_split(it->range_it, n, results);
+
+	if (err)
+		return err;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (int i = 0; i < n; i++) {
+		excit_t tmp;
+
+		tmp = results[i];
+		results[i] = excit_alloc(EXCIT_MORTON);
+		if (!results[i]) {
+			excit_free(tmp);
+			err = -EXCIT_ENOMEM;
+			goto error;
+		}
+		struct morton_it_s *res_it =
+		    (struct morton_it_s *)results[i]->data;
+		err = morton_it_alloc_buffers(res_it, data->dimension);
+		if (err) {
+			excit_free(tmp);
+			goto error;
+		}
+		memcpy(res_it->bits, it->bits,
+		       2 * data->dimension * sizeof(ssize_t));
+		results[i]->dimension = data->dimension;
+		res_it->range_it = tmp;
+		res_it->deposit = it->deposit;
+		res_it->extract = it->extract;
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (int i = 0; i < n; i++)
+		excit_free(results[i]);
+	return err;
+}
+
+struct excit_func_table_s excit_morton_func_table = {
+	morton_it_alloc,
+	morton_it_free,
+	morton_it_copy,
+	morton_it_next,
+	morton_it_peek,
+	morton_it_size,
+	morton_it_rewind,
+	morton_it_split,
+	morton_it_nth,
+	morton_it_rank,
+	morton_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	morton_it_seek,
+	NULL,
+	NULL
+};
+
+int excit_morton_init(excit_t it, ssize_t dim, const ssize_t *bits)
+{
+	struct morton_it_s *morton_it;
+	ssize_t total = 0, max = 0, pos = 0;
+	int err;
+
+	if (!it || it->type != EXCIT_MORTON || dim <= 0 || !bits)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; i < dim; i++) {
+		if (bits[i] < 0)
+			return -EXCIT_EINVAL;
+		total += bits[i];
+		if (bits[i] > max)
+			max = bits[i];
+	}
+	/* the size of the curve must fit in a ssize_t */
+	if (total >= (ssize_t)(8 * sizeof(ssize_t)) - 1)
+		return -EXCIT_EDOM;
+	morton_it = (struct morton_it_s *)it->data;
+	err = morton_it_alloc_buffers(morton_it, dim);
+	if (err)
+		return err;
+	/*
+	 * Bits are interleaved from the least significant ones, the last
+	 * coordinate getting the lowest bit of each level; coordinates with
+	 * fewer bits drop out of the upper levels.
+	 */
+	for (ssize_t i = 0; i < dim; i++) {
+		morton_it->bits[i] = bits[i];
+		morton_it->masks[i] = 0;
+	}
+	for (ssize_t l = 0; l < max; l++)
+		for (ssize_t i = dim - 1; i >= 0; i--)
+			if (l < bits[i])
+				morton_it->masks[i] |= (size_t)1 << pos++;
+	excit_free(morton_it->range_it);
+	morton_it->range_it = excit_alloc(EXCIT_RANGE);
+	if (!morton_it->range_it)
+		return -EXCIT_ENOMEM;
+	err = excit_range_init(morton_it->range_it, 0,
+			       ((ssize_t)1 << total) - 1, 1);
+	if (err)
+		return err;
+	morton_it->deposit = morton_deposit;
+	morton_it->extract = morton_extract;
+#ifdef MORTON_BMI2
+	/* EXCIT_MORTON_PORTABLE in the environment disables BMI2, for tests */
+	if (__builtin_cpu_supports("bmi2") && !getenv("EXCIT_MORTON_PORTABLE")) {
+		morton_it->deposit = morton_deposit_bmi2;
+		morton_it->extract = morton_extract_bmi2;
+	}
+#endif
+	it->dimension = dim;
+	return EXCIT_SUCCESS;
+}
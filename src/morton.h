@@ -0,0 +1,28 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_MORTON_H
+#define EXCIT_MORTON_H
+
+#include "excit.h"
+
+struct morton_it_s {
+	excit_t range_it;
+	/* Number of bits of each coordinate */
+	ssize_t *bits;
+	/* Bits of the curve index holding each coordinate */
+	size_t *masks;
+	/* Bit scatter and gather, chosen at runtime */
+	size_t (*deposit)(size_t val, size_t mask);
+	size_t (*extract)(size_t val, size_t mask);
+};
+
+extern struct excit_func_table_s excit_morton_func_table;
+
+#endif //EXCIT_MORTON_H
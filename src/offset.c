@@ -0,0 +1,415 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <string.h>
+#include "dev/excit.h"
+#include "offset.h"
+#include "range.h"
+#include "box.h"
+#include "prod.h"
+
+/*
+ * Const functions cannot use the coordinates buffer of the iterator: they use
+ * a stack buffer for sources of small dimension, and allocate one otherwise.
+ */
+#define OFFSET_STACK_DIM 8
+
+static int offset_it_alloc(excit_t data)
+{
+	struct offset_it_s *it = (struct offset_it_s *)data->data;
+
+	it->src = NULL;
+	it->base = 0;
+	it->strides = NULL;
+	it->order = NULL;
+	it->lower = NULL;
+	it->origin = 0;
+	it->invertible = 0;
+	it->coords = NULL;
+	it->partial = NULL;
+	return EXCIT_SUCCESS;
+}
+
+static void offset_it_free(excit_t data)
+{
+	struct offset_it_s *it = (struct offset_it_s *)data->data;
+
+	excit_free(it->src);
+	free(it->strides);
+}
+
+/*
+ * Allocates strides, order, lower, coords and partial in a single block for a
+ * source of dimension dim.
+ */
+static int offset_it_alloc_buffers(struct offset_it_s *it, ssize_t dim)
+{
+	ssize_t *buff = malloc((5 * dim + 1) * sizeof(ssize_t));
+
+	if (!buff)
+		return -EXCIT_ENOMEM;
+	free(it->strides);
+	it->strides = buff;
+	it->order = buff + dim;
+	it->lower = buff + 2 * dim;
+	it->coords = buff + 3 * dim;
+	it->partial = buff + 4 * dim;
+	return EXCIT_SUCCESS;
+}
+
+static ssize_t *offset_it_scratch(const struct offset_it_s *it,
+				  ssize_t *stack)
+{
+	if (it->src->dimension <= OFFSET_STACK_DIM)
+		return stack;
+	return malloc(it->src->dimension * sizeof(ssize_t));
+}
+
+static void offset_it_scratch_free(ssize_t *coords, const ssize_t *stack)
+{
+	if (coords != stack)
+		free(coords);
+}
+
+static int offset_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct offset_it_s *dst = (struct offset_it_s *)ddst->data;
+	const struct offset_it_s *src = (const struct offset_it_s *)dsrc->data;
+	ssize_t dim = src->src->dimension;
+	excit_t copy = excit_dup(src->src);
+	int err;
+
+	if (!copy)
+		return -EXCIT_EINVAL;
+	err = offset_it_alloc_buffers(dst, dim);
+	if (err) {
+		excit_free(copy);
+		return err;
+	}
+	dst->src = copy;
+	dst->base = src->base;
+	dst->origin = src->origin;
+	dst->invertible = src->invertible;
+	memcpy(dst->strides, src->strides, (5 * dim + 1) * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
+
+static inline ssize_t offset_it_value(const struct offset_it_s *it,
+				      const ssize_t *coords)
+{
+	ssize_t val = it->base;
+
+	for (ssize_t i = 0; i < it->src->dimension; i++)
+		val += coords[i] * it->strides[i];
+	return val;
+}
+
+/*
+ * Only the partial offsets of the coordinates that changed since the previous
+ * element of the source are recomputed: for a product, usually just the
+ * innermost one.
+ */
+static int offset_it_next_ref(excit_t data, const ssize_t **tuple)
+{
+	struct offset_it_s *it = (struct offset_it_s *)data->data;
+	ssize_t dim = it->src->dimension;
+	ssize_t i;
+	int err = excit_next_delta(it->src, it->coords, &i);
+
+	if (err)
+		return err;
+	for (; i < dim; i++)
+		it->partial[i + 1] = it->partial[i] +
+		    it->coords[i] * it->strides[i];
+	*tuple = it->partial + dim;
+	return EXCIT_SUCCESS;
+}
+
+static int offset_it_next(excit_t data, ssize_t *indexes)
+{
+	const ssize_t *tuple;
+	int err = offset_it_next_ref(data, &tuple);
+
+	if (err)
+		return err;
+	if (indexes)
+		*indexes = *tuple;
+	return EXCIT_SUCCESS;
+}
+
+static int offset_it_next_batch(excit_t data, ssize_t max, ssize_t *indexes,
+				ssize_t *produced)
+{
+	const ssize_t *tuple;
+	ssize_t count;
+	int err = EXCIT_SUCCESS;
+
+	for (count = 0; count < max; count++) {
+		err = offset_it_next_ref(data, &tuple);
+		if (err)
+			break;
+		if (indexes)
+			indexes[count] = *tuple;
+	}
+	if (count == 0 || err < 0)
+		return err;
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int offset_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+	ssize_t stack[OFFSET_STACK_DIM];
+	ssize_t *coords = offset_it_scratch(it, stack);
+	int err;
+
+	if (!coords)
+		return -EXCIT_ENOMEM;
+	err = excit_peek(it->src, coords);
+	if (!err && indexes)
+		*indexes = offset_it_value(it, coords);
+	offset_it_scratch_free(coords, stack);
+	return err;
+}
+
+static int offset_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+
+	return excit_size(it->src, size);
+}
+
+static int offset_it_rewind(excit_t data)
+{
+	struct offset_it_s *it = (struct offset_it_s *)data->data;
+
+	return excit_rewind(it->src);
+}
+
+static int offset_it_seek(excit_t data, ssize_t rank)
+{
+	struct offset_it_s *it = (struct offset_it_s *)data->data;
+
+	return excit_seek(it->src, rank);
+}
+
+static int offset_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+
+	return excit_pos(it->src, n);
+}
+
+static int offset_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+	ssize_t stack[OFFSET_STACK_DIM];
+	ssize_t *coords = offset_it_scratch(it, stack);
+	int err;
+
+	if (!coords)
+		return -EXCIT_ENOMEM;
+	err = excit_nth(it->src, n, coords);
+	if (!err && indexes)
+		*indexes = offset_it_value(it, coords);
+	offset_it_scratch_free(coords, stack);
+	return err;
+}
+
+/*
+ * Inverts a nested layout by dividing the offset relative to the lower corner
+ * by strides in decreasing order. The source iterator then checks the
+ * coordinates belong to it.
+ */
+static int offset_it_rank(const_excit_t data, const ssize_t *indexes,
+			  ssize_t *n)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+	ssize_t stack[OFFSET_STACK_DIM];
+	ssize_t *coords;
+	ssize_t rem;
+	int err;
+
+	if (!it->invertible)
+		return -EXCIT_ENOTSUP;
+	rem = *indexes - it->origin;
+	if (rem < 0)
+		return -EXCIT_EINVAL;
+	coords = offset_it_scratch(it, stack);
+	if (!coords)
+		return -EXCIT_ENOMEM;
+	for (ssize_t i = 0; i < it->src->dimension; i++) {
+		ssize_t d = it->order[i];
+
+		coords[d] = it->lower[d] + rem / it->strides[d];
+		rem %= it->strides[d];
+	}
+	if (rem != 0)
+		err = -EXCIT_EINVAL;
+	else
+		err = excit_rank(it->src, coords, n);
+	offset_it_scratch_free(coords, stack);
+	return err;
+}
+
+static int offset_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct offset_it_s *it = (const struct offset_it_s *)data->data;
+	int err = excit_split(it->src, n, results);
+
+	if (err)
+		return err;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (int i = 0; i < n; i++) {
+		excit_t tmp = results[i];
+
+		results[i] = excit_alloc(EXCIT_OFFSET);
+		if (!results[i]) {
+			excit_free(tmp);
+			err = -EXCIT_ENOMEM;
+			goto error;
+		}
+		err = excit_offset_init(results[i], tmp, it->strides, it->base);
+		if (err) {
+			excit_free(tmp);
+			goto error;
+		}
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (int i = 0; i < n; i++)
+		excit_free(results[i]);
+	return err;
+}
+
+struct excit_func_table_s excit_offset_func_table = {
+	offset_it_alloc,
+	offset_it_free,
+	offset_it_copy,
+	offset_it_next,
+	offset_it_peek,
+	offset_it_size,
+	offset_it_rewind,
+	offset_it_split,
+	offset_it_nth,
+	offset_it_rank,
+	offset_it_pos,
+	offset_it_next_batch,
+	NULL,
+	NULL,
+	offset_it_seek,
+	offset_it_next_ref,
+	NULL
+};
+
+/*
+ * Gets the bounds of each coordinate of ranges, boxes and their products.
+ * Split iterators get the bounds of the space they were split from.
+ */
+static int offset_src_bounds(const_excit_t src, ssize_t *lower,
+			     ssize_t *upper)
+{
+	const struct range_it_s *range_it;
+	const struct box_it_s *box_it;
+	const struct prod_it_s *prod_it;
+	int err;
+
+	switch (src->type) {
+	case EXCIT_RANGE:
+		range_it = (const struct range_it_s *)src->data;
+		lower[0] = range_it->first < range_it->last ?
+		    range_it->first : range_it->last;
+		upper[0] = range_it->first < range_it->last ?
+		    range_it->last : range_it->first;
+		return EXCIT_SUCCESS;
+	case EXCIT_BOX:
+		box_it = (const struct box_it_s *)src->data;
+		for (ssize_t i = 0; i < src->dimension; i++) {
+			lower[i] = box_it->lower[i] < box_it->upper[i] ?
+			    box_it->lower[i] : box_it->upper[i];
+			upper[i] = box_it->lower[i] < box_it->upper[i] ?
+			    box_it->upper[i] : box_it->lower[i];
+		}
+		return EXCIT_SUCCESS;
+	case EXCIT_PRODUCT:
+		prod_it = (const struct prod_it_s *)src->data;
+		for (ssize_t i = 0; i < prod_it->count; i++) {
+			err = offset_src_bounds(prod_it->its[i],
+						lower + prod_it->offsets[i],
+						upper + prod_it->offsets[i]);
+			if (err)
+				return err;
+		}
+		return EXCIT_SUCCESS;
+	default:
+		return -EXCIT_ENOTSUP;
+	}
+}
+
+/*
+ * Offsets can be inverted when the bounds of the coordinates are known and
+ * each stride exceeds the largest offset reachable with smaller strides.
+ */
+static void offset_it_check_nested(struct offset_it_s *it)
+{
+	ssize_t dim = it->src->dimension;
+	ssize_t span = 0;
+
+	it->invertible = 0;
+	it->origin = it->base;
+	for (ssize_t i = 0; i < dim; i++)
+		if (it->strides[i] <= 0)
+			return;
+	/* the coordinates buffer is free until the iterator is used */
+	if (offset_src_bounds(it->src, it->lower, it->coords))
+		return;
+	for (ssize_t i = dim - 1; i >= 0; i--) {
+		ssize_t d = it->order[i];
+
+		if (it->strides[d] <= span)
+			return;
+		span += it->strides[d] * (it->coords[d] - it->lower[d]);
+	}
+	for (ssize_t i = 0; i < dim; i++)
+		it->origin += it->lower[i] * it->strides[i];
+	it->invertible = 1;
+}
+
+int excit_offset_init(excit_t it, excit_t src, const ssize_t *strides,
+		      ssize_t base)
+{
+	if (!it || it->type != EXCIT_OFFSET || !src || src->dimension <= 0
+	    || !strides)
+		return -EXCIT_EINVAL;
+	struct offset_it_s *offset_it = (struct offset_it_s *)it->data;
+	ssize_t dim = src->dimension;
+	int err = offset_it_alloc_buffers(offset_it, dim);
+
+	if (err)
+		return err;
+	excit_free(offset_it->src);
+	it->dimension = 1;
+	offset_it->src = src;
+	offset_it->base = base;
+	for (ssize_t i = 0; i < dim; i++) {
+		ssize_t j;
+
+		offset_it->strides[i] = strides[i];
+		/* insertion sort by decreasing stride */
+		for (j = i; j > 0 && strides[offset_it->order[j - 1]] <
+		     strides[i]; j--)
+			offset_it->order[j] = offset_it->order[j - 1];
+		offset_it->order[j] = i;
+	}
+	offset_it_check_nested(offset_it);
+	offset_it->partial[0] = base;
+	return EXCIT_SUCCESS;
+}
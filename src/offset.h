@@ -0,0 +1,40 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_OFFSET_H
+#define EXCIT_OFFSET_H
+
+#include "excit.h"
+#include "dev/excit.h"
+
+struct offset_it_s {
+	excit_t src;
+	ssize_t base;
+	/* Stride of each coordinate of src */
+	ssize_t *strides;
+	/* Coordinates sorted by decreasing stride, used to invert the layout */
+	ssize_t *order;
+	/* Lower bound of each coordinate of src, and its offset */
+	ssize_t *lower;
+	ssize_t origin;
+	/*
+	 * Whether the layout is nested: strides are positive and each one
+	 * exceeds the span of the offsets of the coordinates with smaller
+	 * strides. Offsets can then be inverted.
+	 */
+	int invertible;
+	/* Last element returned by src */
+	ssize_t *coords;
+	/* partial[d] is the offset of coords restricted to their d first ones */
+	ssize_t *partial;
+};
+
+extern struct excit_func_table_s excit_offset_func_table;
+
+#endif //EXCIT_OFFSET_H
@@ -0,0 +1,279 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdlib.h>
+#include "dev/excit.h"
+#include "composition.h"
+#include "prod.h"
+#include "repeat.h"
+#include "range.h"
+#include "loop.h"
+
+/*
+ * Every rewrite replaces a subtree by an equivalent one: same dimension, same
+ * elements in the same order, same ranks. Children are rewritten first, so a
+ * node only has to look one level down. Positions of rewritten subtrees are
+ * left unspecified, excit_optimize() restores the position of the root once
+ * the whole tree is rewritten.
+ */
+static int optimize_tree(excit_t *it);
+
+/* Replaces a node by one of its children, which is detached beforehand */
+static void optimize_replace(excit_t *it, excit_t child)
+{
+	excit_free(*it);
+	*it = child;
+}
+
+/* repeat(repeat(x, a), b) is repeat(x, a * b), repeat(x, 1) is x */
+static int optimize_repeat(excit_t *it)
+{
+	struct repeat_it_s *repeat_it = (struct repeat_it_s *)(*it)->data;
+	excit_t child;
+	int err = optimize_tree(&repeat_it->it);
+
+	if (err)
+		return err;
+	child = repeat_it->it;
+	if (repeat_it->n == 1) {
+		repeat_it->it = NULL;
+		optimize_replace(it, child);
+	} else if (child->type == EXCIT_REPEAT) {
+		struct repeat_it_s *child_it = (struct repeat_it_s *)child->data;
+		excit_t grandchild = child_it->it;
+
+		child_it->it = NULL;
+		err = excit_repeat_init(child, grandchild,
+					child_it->n * repeat_it->n);
+		if (err) {
+			child_it->it = grandchild;
+			return err;
+		}
+		repeat_it->it = NULL;
+		optimize_replace(it, child);
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* loop(loop(x, a), b) is loop(x, a * b), loop(x, 1) is x */
+static int optimize_loop(excit_t *it)
+{
+	struct loop_it_s *loop_it = (struct loop_it_s *)(*it)->data;
+	excit_t child;
+	int err = optimize_tree(&loop_it->it);
+
+	if (err)
+		return err;
+	child = loop_it->it;
+	if (loop_it->n == 1) {
+		loop_it->it = NULL;
+		optimize_replace(it, child);
+	} else if (child->type == EXCIT_LOOP) {
+		struct loop_it_s *child_it = (struct loop_it_s *)child->data;
+		excit_t grandchild = child_it->it;
+
+		child_it->it = NULL;
+		err = excit_loop_init(child, grandchild,
+				      child_it->n * loop_it->n);
+		if (err) {
+			child_it->it = grandchild;
+			return err;
+		}
+		loop_it->it = NULL;
+		optimize_replace(it, child);
+	}
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * A range indexed by a range is a range, as long as every index is a rank of
+ * the source; a source indexed by all its ranks in order is the source.
+ */
+static int optimize_composition(excit_t *it)
+{
+	struct composition_it_s *composition_it =
+	    (struct composition_it_s *)(*it)->data;
+	excit_t src, indexer, range;
+	ssize_t src_size, size, first, last;
+	int err;
+
+	err = optimize_tree(&composition_it->src);
+	if (err)
+		return err;
+	err = optimize_tree(&composition_it->indexer);
+	if (err)
+		return err;
+	src = composition_it->src;
+	indexer = composition_it->indexer;
+	if (indexer->type != EXCIT_RANGE)
+		return EXCIT_SUCCESS;
+	if (excit_size(src, &src_size) || excit_size(indexer, &size) ||
+	    size == 0)
+		return EXCIT_SUCCESS;
+	if (excit_nth(indexer, 0, &first) ||
+	    excit_nth(indexer, size - 1, &last))
+		return EXCIT_SUCCESS;
+	if (first < 0 || first >= src_size || last < 0 || last >= src_size)
+		return EXCIT_SUCCESS;
+
+	const struct range_it_s *indexer_it =
+	    (const struct range_it_s *)indexer->data;
+
+	if (first == 0 && indexer_it->step == 1 && size == src_size) {
+		composition_it->src = NULL;
+		optimize_replace(it, src);
+		return EXCIT_SUCCESS;
+	}
+	if (src->type != EXCIT_RANGE)
+		return EXCIT_SUCCESS;
+
+	const struct range_it_s *src_it = (const struct range_it_s *)src->data;
+
+	range = excit_alloc(EXCIT_RANGE);
+	if (!range)
+		return -EXCIT_ENOMEM;
+	err = excit_range_init(range, src_it->first + first * src_it->step,
+			       src_it->first + last * src_it->step,
+			       indexer_it->step * src_it->step);
+	if (err) {
+		excit_free(range);
+		return err;
+	}
+	optimize_replace(it, range);
+	return EXCIT_SUCCESS;
+}
+
+/* Whether an iterator is a product iterating over its whole space */
+static int optimize_is_whole_product(const_excit_t it)
+{
+	const struct prod_it_s *prod_it = (const struct prod_it_s *)it->data;
+
+	if (it->type != EXCIT_PRODUCT)
+		return 0;
+	return prod_it->first == 0 && prod_it->end == prod_it->size;
+}
+
+/*
+ * Factors that are products over their whole space are replaced by their own
+ * factors, runs of ranges are collapsed into boxes, and a product over its
+ * whole space with a single factor is that factor.
+ */
+static int optimize_product(excit_t *it)
+{
+	struct prod_it_s *prod_it = (struct prod_it_s *)(*it)->data;
+	struct prod_it_s *flat_it;
+	excit_t flat;
+	ssize_t added = 0;
+	int nested = 0;
+	int err;
+
+	if (prod_it->count == 0)
+		return EXCIT_SUCCESS;
+	for (ssize_t i = 0; i < prod_it->count; i++) {
+		err = optimize_tree(prod_it->its + i);
+		if (err)
+			return err;
+		nested |= optimize_is_whole_product(prod_it->its[i]);
+	}
+	if (nested) {
+		flat = excit_alloc(EXCIT_PRODUCT);
+		if (!flat)
+			return -EXCIT_ENOMEM;
+		flat_it = (struct prod_it_s *)flat->data;
+		for (ssize_t i = 0; i < prod_it->count; i++) {
+			excit_t factor = prod_it->its[i];
+			struct prod_it_s *factor_it =
+			    (struct prod_it_s *)factor->data;
+
+			if (!optimize_is_whole_product(factor)) {
+				err = excit_product_add(flat, factor);
+				if (err)
+					goto error;
+				added++;
+				continue;
+			}
+			for (ssize_t j = 0; j < factor_it->count; j++) {
+				err = excit_product_add(flat,
+							factor_it->its[j]);
+				if (err)
+					goto error;
+				added++;
+			}
+		}
+		/* factors now belong to the flat product, free the shells */
+		for (ssize_t i = 0; i < prod_it->count; i++) {
+			excit_t factor = prod_it->its[i];
+
+			if (optimize_is_whole_product(factor)) {
+				struct prod_it_s *factor_it =
+				    (struct prod_it_s *)factor->data;
+
+				for (ssize_t j = 0; j < factor_it->count; j++)
+					factor_it->its[j] = NULL;
+				excit_free(factor);
+			}
+			prod_it->its[i] = NULL;
+		}
+		flat_it->first = prod_it->first;
+		flat_it->end = prod_it->end;
+		optimize_replace(it, flat);
+		prod_it = flat_it;
+	}
+	err = excit_product_collapse(*it);
+	if (err && err != -EXCIT_ENOTSUP)
+		return err;
+	if (prod_it->count == 1 && optimize_is_whole_product(*it)) {
+		excit_t factor = prod_it->its[0];
+
+		prod_it->its[0] = NULL;
+		optimize_replace(it, factor);
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (ssize_t i = 0; i < added; i++)
+		flat_it->its[i] = NULL;
+	excit_free(flat);
+	return err;
+}
+
+static int optimize_tree(excit_t *it)
+{
+	switch ((*it)->type) {
+	case EXCIT_PRODUCT:
+		return optimize_product(it);
+	case EXCIT_COMPOSITION:
+		return optimize_composition(it);
+	case EXCIT_REPEAT:
+		return optimize_repeat(it);
+	case EXCIT_LOOP:
+		return optimize_loop(it);
+	default:
+		return EXCIT_SUCCESS;
+	}
+}
+
+int excit_optimize(excit_t *it)
+{
+	ssize_t pos;
+	int err;
+
+	if (!it || !*it || !(*it)->func_table)
+		return -EXCIT_EINVAL;
+	err = excit_pos(*it, &pos);
+	if (err == EXCIT_STOPIT) {
+		/* rewrites preserve the size */
+		err = excit_size(*it, &pos);
+	}
+	if (err)
+		return err;
+	err = optimize_tree(it);
+	if (err)
+		return err;
+	return excit_seek(*it, pos);
+}
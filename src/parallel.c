@@ -0,0 +1,328 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "dev/excit.h"
+#include "excit_parallel.h"
+
+/* Number of elements materialized at once by a worker */
+#define PARALLEL_BATCH 64
+
+/* Number of chunks per worker when the grain is chosen from the size */
+#define PARALLEL_CHUNKS 16
+
+struct parallel_s;
+
+/*
+ * A worker owns the interval of tasks [lo, hi). Tasks are ranks of the
+ * iterator, or parts of the iterator when it is split. The owner takes
+ * tasks from the front and thieves take the back half, so a worker always
+ * owns a single interval.
+ */
+struct parallel_worker_s {
+	pthread_mutex_t lock;
+	ssize_t lo;
+	ssize_t hi;
+	int id;
+	pthread_t thread;
+	struct parallel_s *shared;
+};
+
+struct parallel_s {
+	const_excit_t it;
+	/* Parts traversed with excit_next(), or NULL to use excit_nth() */
+	excit_t *parts;
+	ssize_t nparts;
+	/* Rank of the first element of each part, -1 if unknown */
+	ssize_t *part_first;
+	ssize_t dim;
+	ssize_t grain;
+	excit_parallel_fn_t fn;
+	void *ctx;
+	pthread_mutex_t lock;
+	int stop;
+	int result;
+	int nworkers;
+	struct parallel_worker_s *workers;
+};
+
+static void parallel_stop(struct parallel_s *p, int result)
+{
+	pthread_mutex_lock(&p->lock);
+	if (!p->stop) {
+		p->stop = 1;
+		p->result = result;
+	}
+	pthread_mutex_unlock(&p->lock);
+}
+
+static int parallel_stopped(struct parallel_s *p)
+{
+	int stop;
+
+	pthread_mutex_lock(&p->lock);
+	stop = p->stop;
+	pthread_mutex_unlock(&p->lock);
+	return stop;
+}
+
+/* Moves the back half of the tasks of another worker to w */
+static int parallel_steal(struct parallel_worker_s *w)
+{
+	struct parallel_s *p = w->shared;
+
+	for (int i = 1; i < p->nworkers; i++) {
+		struct parallel_worker_s *v =
+		    p->workers + (w->id + i) % p->nworkers;
+		ssize_t lo = 0, hi = 0;
+
+		pthread_mutex_lock(&v->lock);
+		if (v->lo < v->hi) {
+			lo = v->lo + (v->hi - v->lo) / 2;
+			hi = v->hi;
+			v->hi = lo;
+		}
+		pthread_mutex_unlock(&v->lock);
+		if (lo < hi) {
+			pthread_mutex_lock(&w->lock);
+			w->lo = lo;
+			w->hi = hi;
+			pthread_mutex_unlock(&w->lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Takes up to grain tasks [*lo, *hi), stealing if w has none left */
+static int parallel_take(struct parallel_worker_s *w, ssize_t *lo,
+			 ssize_t *hi)
+{
+	ssize_t grain = w->shared->parts ? 1 : w->shared->grain;
+
+	do {
+		pthread_mutex_lock(&w->lock);
+		*lo = w->lo;
+		*hi = w->hi - w->lo < grain ? w->hi : w->lo + grain;
+		w->lo = *hi;
+		pthread_mutex_unlock(&w->lock);
+		if (*lo < *hi)
+			return 1;
+	} while (parallel_steal(w));
+	return 0;
+}
+
+static int parallel_run_ranks(struct parallel_worker_s *w, ssize_t lo,
+			      ssize_t hi, ssize_t *buf)
+{
+	struct parallel_s *p = w->shared;
+	ssize_t ranks[PARALLEL_BATCH];
+	int err;
+
+	while (lo < hi && !parallel_stopped(p)) {
+		ssize_t n = hi - lo < PARALLEL_BATCH ? hi - lo : PARALLEL_BATCH;
+
+		for (ssize_t i = 0; i < n; i++)
+			ranks[i] = lo + i;
+		err = excit_nth_batch(p->it, n, ranks, buf);
+		if (err)
+			return err;
+		for (ssize_t i = 0; i < n; i++) {
+			err = p->fn(buf + i * p->dim, ranks[i], w->id, p->ctx);
+			if (err)
+				return err;
+		}
+		lo += n;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int parallel_run_part(struct parallel_worker_s *w, ssize_t part,
+			     ssize_t *buf)
+{
+	struct parallel_s *p = w->shared;
+	ssize_t rank = p->part_first[part];
+	ssize_t n;
+	int err;
+
+	while (!parallel_stopped(p)) {
+		err = excit_next_batch(p->parts[part], PARALLEL_BATCH, buf, &n);
+		if (err == EXCIT_STOPIT)
+			return EXCIT_SUCCESS;
+		if (err)
+			return err;
+		for (ssize_t i = 0; i < n; i++) {
+			err = p->fn(buf + i * p->dim, rank < 0 ? -1 : rank + i,
+				    w->id, p->ctx);
+			if (err)
+				return err;
+		}
+		if (rank >= 0)
+			rank += n;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static void *parallel_worker(void *arg)
+{
+	struct parallel_worker_s *w = (struct parallel_worker_s *)arg;
+	struct parallel_s *p = w->shared;
+	ssize_t *buf;
+	ssize_t lo, hi;
+	int err = EXCIT_SUCCESS;
+
+	buf = malloc(PARALLEL_BATCH * (p->dim ? p->dim : 1) * sizeof(ssize_t));
+	if (!buf) {
+		parallel_stop(p, -EXCIT_ENOMEM);
+		return NULL;
+	}
+	while (!err && !parallel_stopped(p) && parallel_take(w, &lo, &hi)) {
+		if (!p->parts)
+			err = parallel_run_ranks(w, lo, hi, buf);
+		for (ssize_t part = lo; p->parts && !err && part < hi; part++)
+			err = parallel_run_part(w, part, buf);
+	}
+	if (err)
+		parallel_stop(p, err);
+	free(buf);
+	return NULL;
+}
+
+/*
+ * Divides an iterator of the given size that cannot be accessed by rank into
+ * at most n parts, rewound and traversed in order.
+ */
+static int parallel_split(struct parallel_s *p, ssize_t size, ssize_t n)
+{
+	ssize_t part_size;
+	int err;
+
+	if (!p->it->func_table->split)
+		return -EXCIT_ENOTSUP;
+	if (size < n)
+		n = size;
+	p->parts = (excit_t *)malloc(n * sizeof(excit_t));
+	p->part_first = (ssize_t *)malloc(n * sizeof(ssize_t));
+	if (!p->parts || !p->part_first)
+		return -EXCIT_ENOMEM;
+	err = excit_split(p->it, n, p->parts);
+	if (err)
+		return err;
+	p->nparts = n;
+	p->part_first[0] = 0;
+	for (ssize_t i = 0; i < n; i++) {
+		err = excit_rewind(p->parts[i]);
+		if (err)
+			return err;
+		if (i == n - 1)
+			break;
+		if (p->part_first[i] < 0 ||
+		    excit_size(p->parts[i], &part_size) != EXCIT_SUCCESS)
+			p->part_first[i + 1] = -1;
+		else
+			p->part_first[i + 1] = p->part_first[i] + part_size;
+	}
+	return EXCIT_SUCCESS;
+}
+
+int excit_parallel_for(const_excit_t it, int nthreads, ssize_t grain,
+		       excit_parallel_fn_t fn, void *ctx)
+{
+	struct parallel_s p;
+	ssize_t size, ntasks;
+	ssize_t *probe;
+	int started = 1;
+	int err;
+
+	if (!it || !it->func_table || !fn)
+		return -EXCIT_EINVAL;
+	if (nthreads < 0 || grain < 0)
+		return -EXCIT_EDOM;
+	if (!nthreads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		nthreads = cpus > 0 ? (int)cpus : 1;
+	}
+	p.it = it;
+	p.parts = NULL;
+	p.nparts = 0;
+	p.part_first = NULL;
+	p.dim = it->dimension;
+	p.fn = fn;
+	p.ctx = ctx;
+	p.stop = 0;
+	p.result = EXCIT_SUCCESS;
+	p.nworkers = nthreads;
+	p.workers = NULL;
+
+	err = excit_size(it, &size);
+	if (err)
+		return err;
+	if (!size)
+		return EXCIT_SUCCESS;
+	/* Composite iterators only query their children for actual indexes */
+	probe = (ssize_t *)malloc((p.dim ? p.dim : 1) * sizeof(ssize_t));
+	if (!probe)
+		return -EXCIT_ENOMEM;
+	err = excit_nth(it, 0, probe);
+	free(probe);
+	if (err == -EXCIT_ENOTSUP) {
+		err = parallel_split(&p, size, nthreads);
+		if (err)
+			goto error;
+		ntasks = p.nparts;
+		p.grain = 1;
+	} else {
+		ntasks = size;
+		p.grain = grain;
+		if (!p.grain)
+			p.grain = size / ((ssize_t)nthreads * PARALLEL_CHUNKS);
+		if (!p.grain)
+			p.grain = 1;
+	}
+
+	p.workers = (struct parallel_worker_s *)
+	    malloc(nthreads * sizeof(struct parallel_worker_s));
+	if (!p.workers) {
+		err = -EXCIT_ENOMEM;
+		goto error;
+	}
+	pthread_mutex_init(&p.lock, NULL);
+	for (int i = 0; i < nthreads; i++) {
+		p.workers[i].lo = excit_split_offset(ntasks, nthreads, i);
+		p.workers[i].hi = excit_split_offset(ntasks, nthreads, i + 1);
+		p.workers[i].id = i;
+		p.workers[i].shared = &p;
+		pthread_mutex_init(&p.workers[i].lock, NULL);
+	}
+	/*
+	 * The calling thread is worker 0. Workers that cannot be started keep
+	 * their tasks until the others steal them.
+	 */
+	while (started < nthreads &&
+	       !pthread_create(&p.workers[started].thread, NULL,
+			       parallel_worker, p.workers + started))
+		started++;
+	parallel_worker(p.workers);
+	for (int i = 1; i < started; i++)
+		pthread_join(p.workers[i].thread, NULL);
+	err = p.result;
+	for (int i = 0; i < nthreads; i++)
+		pthread_mutex_destroy(&p.workers[i].lock);
+	pthread_mutex_destroy(&p.lock);
+error:
+	for (ssize_t i = 0; i < p.nparts; i++)
+		excit_free(p.parts[i]);
+	free(p.parts);
+	free(p.part_first);
+	free(p.workers);
+	return err;
+}
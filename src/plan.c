@@ -0,0 +1,825 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "plan.h"
+#include "box.h"
+#include "composition.h"
+#include "loop.h"
+#include "offset.h"
+#include "prod.h"
+#include "range.h"
+#include "repeat.h"
+
+#define PLAN_REALLOC(ptr, n) do { \
+	size_t bytes = (n) * sizeof(*(ptr)); \
+	void *p = realloc(ptr, bytes ? bytes : 1); \
+	if (!p) \
+		return -EXCIT_ENOMEM; \
+	ptr = p; \
+} while (0)
+
+static void plan_it_reset(struct plan_it_s *it)
+{
+	it->count = 0;
+	it->radices = NULL;
+	it->radix_divs = NULL;
+	it->base = NULL;
+	it->coefs = NULL;
+	it->carries = NULL;
+	it->leaves = NULL;
+	it->leaf_offsets = NULL;
+	it->last_leaf = -1;
+	it->digits = NULL;
+	it->cur = NULL;
+	it->rank = 0;
+	it->first = 0;
+	it->end = -1;
+	it->size = 0;
+	it->tree = NULL;
+	it->tree_first = 0;
+}
+
+static void plan_it_clear(struct plan_it_s *it)
+{
+	for (ssize_t k = 0; it->leaves && k < it->count; k++)
+		excit_free(it->leaves[k]);
+	excit_free(it->tree);
+	free(it->radices);
+	free(it->radix_divs);
+	free(it->base);
+	free(it->coefs);
+	free(it->carries);
+	free(it->leaves);
+	free(it->leaf_offsets);
+	free(it->digits);
+	free(it->cur);
+	plan_it_reset(it);
+}
+
+static int plan_it_alloc(excit_t data)
+{
+	plan_it_reset((struct plan_it_s *)data->data);
+	return EXCIT_SUCCESS;
+}
+
+static void plan_it_free(excit_t data)
+{
+	plan_it_clear((struct plan_it_s *)data->data);
+}
+
+/*
+ * Resizes the arrays holding digits to count digits, new leaves are NULL.
+ * The number of digits is left to the caller.
+ */
+static int plan_it_resize(struct plan_it_s *it, ssize_t dim, ssize_t count)
+{
+	PLAN_REALLOC(it->leaves, count);
+	for (ssize_t k = it->count; k < count; k++)
+		it->leaves[k] = NULL;
+	PLAN_REALLOC(it->radices, count);
+	PLAN_REALLOC(it->radix_divs, count);
+	PLAN_REALLOC(it->coefs, count * dim);
+	PLAN_REALLOC(it->carries, count * dim);
+	PLAN_REALLOC(it->leaf_offsets, count);
+	PLAN_REALLOC(it->digits, count);
+	if (!it->base)
+		it->base = calloc(dim ? dim : 1, sizeof(ssize_t));
+	if (!it->cur)
+		it->cur = malloc((dim ? dim : 1) * sizeof(ssize_t));
+	if (!it->base || !it->cur)
+		return -EXCIT_ENOMEM;
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct plan_it_s *dst = (struct plan_it_s *)ddst->data;
+	const struct plan_it_s *src = (const struct plan_it_s *)dsrc->data;
+	ssize_t dim = dsrc->dimension;
+	ssize_t count = src->count;
+	int err = plan_it_resize(dst, dim, count);
+
+	if (err)
+		return err;
+	dst->count = count;
+	memcpy(dst->radices, src->radices, count * sizeof(ssize_t));
+	memcpy(dst->radix_divs, src->radix_divs,
+	       count * sizeof(struct excit_divisor_s));
+	memcpy(dst->base, src->base, dim * sizeof(ssize_t));
+	memcpy(dst->coefs, src->coefs, count * dim * sizeof(ssize_t));
+	memcpy(dst->carries, src->carries, count * dim * sizeof(ssize_t));
+	memcpy(dst->leaf_offsets, src->leaf_offsets, count * sizeof(ssize_t));
+	memcpy(dst->digits, src->digits, count * sizeof(ssize_t));
+	memcpy(dst->cur, src->cur, dim * sizeof(ssize_t));
+	for (ssize_t k = 0; k < count; k++) {
+		if (!src->leaves[k])
+			continue;
+		dst->leaves[k] = excit_dup(src->leaves[k]);
+		if (!dst->leaves[k])
+			return -EXCIT_ENOMEM;
+	}
+	dst->tree = excit_dup(src->tree);
+	if (!dst->tree)
+		return -EXCIT_ENOMEM;
+	dst->rank = src->rank;
+	dst->first = src->first;
+	dst->end = src->end;
+	dst->size = src->size;
+	dst->tree_first = src->tree_first;
+	dst->last_leaf = src->last_leaf;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Appends an innermost digit of the given radix. coef is the row of
+ * coefficients of the digit, NULL for zeros. Ownership of leaf is transferred
+ * on success. Digits that are always 0 are dropped.
+ */
+static int plan_it_add_digit(struct plan_it_s *it, ssize_t dim, ssize_t radix,
+			     const ssize_t *coef, excit_t leaf,
+			     ssize_t leaf_offset)
+{
+	int err;
+
+	if (radix == 1 && !leaf)
+		return EXCIT_SUCCESS;
+	err = plan_it_resize(it, dim, it->count + 1);
+	if (err)
+		return err;
+	it->radices[it->count] = radix;
+	if (coef)
+		memcpy(it->coefs + it->count * dim, coef,
+		       dim * sizeof(ssize_t));
+	else
+		memset(it->coefs + it->count * dim, 0, dim * sizeof(ssize_t));
+	it->leaves[it->count] = leaf;
+	it->leaf_offsets[it->count] = leaf_offset;
+	it->count++;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Appends the digits of part, the plan of a part_dim dimensional iterator
+ * whose coordinates start at off, and moves its leaves.
+ */
+static int plan_it_append(struct plan_it_s *it, ssize_t dim,
+			  struct plan_it_s *part, ssize_t part_dim, ssize_t off)
+{
+	ssize_t count;
+	int err;
+
+	memcpy(it->base + off, part->base, part_dim * sizeof(ssize_t));
+	for (ssize_t k = 0; k < part->count; k++) {
+		count = it->count;
+		err = plan_it_add_digit(it, dim, part->radices[k], NULL,
+					part->leaves[k],
+					part->leaf_offsets[k] + off);
+		if (err)
+			return err;
+		part->leaves[k] = NULL;
+		if (it->count > count)
+			memcpy(it->coefs + count * dim + off,
+			       part->coefs + k * part_dim,
+			       part_dim * sizeof(ssize_t));
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Whether no coordinate of the plan is computed by a leaf */
+static int plan_it_is_affine(const struct plan_it_s *it)
+{
+	for (ssize_t k = 0; k < it->count; k++)
+		if (it->leaves[k])
+			return 0;
+	return 1;
+}
+
+static int plan_lower(struct plan_it_s *plan, const_excit_t it, int root);
+
+/* Lowers it into a new plan, part must be cleared by the caller */
+static int plan_lower_part(struct plan_it_s *part, const_excit_t it)
+{
+	plan_it_reset(part);
+	return plan_lower(part, it, 0);
+}
+
+/* Iterators that could not be lowered are driven by a single digit */
+static int plan_lower_leaf(struct plan_it_s *plan, const_excit_t it)
+{
+	ssize_t size;
+	excit_t leaf;
+	int err = excit_size(it, &size);
+
+	if (err)
+		return err;
+	leaf = excit_dup(it);
+	if (!leaf)
+		return -EXCIT_ENOMEM;
+	err = plan_it_add_digit(plan, it->dimension, size, NULL, leaf, 0);
+	if (err)
+		excit_free(leaf);
+	return err;
+}
+
+static int plan_lower_range(struct plan_it_s *plan, const_excit_t it)
+{
+	const struct range_it_s *range_it =
+	    (const struct range_it_s *)it->data;
+	ssize_t size;
+	int err = excit_size(it, &size);
+
+	if (err)
+		return err;
+	plan->base[0] = range_it->first;
+	return plan_it_add_digit(plan, 1, size, &range_it->step, NULL, 0);
+}
+
+static int plan_lower_box(struct plan_it_s *plan, const_excit_t it, int root)
+{
+	const struct box_it_s *box_it = (const struct box_it_s *)it->data;
+	ssize_t dim = it->dimension;
+	ssize_t count;
+	int err;
+
+	if (box_it->first != 0 || box_it->end != box_it->size) {
+		if (!root)
+			return -EXCIT_ENOTSUP;
+		plan->first = box_it->first;
+		plan->end = box_it->end;
+	}
+	for (ssize_t i = 0; i < dim; i++) {
+		plan->base[i] = box_it->lower[i];
+		count = plan->count;
+		err = plan_it_add_digit(plan, dim, box_it->sizes[i], NULL, NULL,
+					0);
+		if (err)
+			return err;
+		if (plan->count > count)
+			plan->coefs[count * dim + i] = box_it->step[i];
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Factors are digits of the product, a slice is only kept at the root */
+static int plan_lower_product(struct plan_it_s *plan, const_excit_t it,
+			      int root)
+{
+	const struct prod_it_s *prod_it = (const struct prod_it_s *)it->data;
+	struct plan_it_s part;
+	int err;
+
+	if (prod_it->count == 0 || prod_it->size < 0)
+		return -EXCIT_ENOTSUP;
+	if (prod_it->first != 0 || prod_it->end != prod_it->size) {
+		if (!root)
+			return -EXCIT_ENOTSUP;
+		plan->first = prod_it->first;
+		plan->end = prod_it->end;
+	}
+	for (ssize_t i = 0; i < prod_it->count; i++) {
+		err = plan_lower_part(&part, prod_it->its[i]);
+		if (!err)
+			err = plan_it_append(plan, it->dimension, &part,
+					     prod_it->its[i]->dimension,
+					     prod_it->offsets[i]);
+		plan_it_clear(&part);
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Each element of the source is repeated by an inner digit */
+static int plan_lower_repeat(struct plan_it_s *plan, const_excit_t it)
+{
+	const struct repeat_it_s *repeat_it =
+	    (const struct repeat_it_s *)it->data;
+	int err = plan_lower(plan, repeat_it->it, 0);
+
+	if (err)
+		return err;
+	return plan_it_add_digit(plan, it->dimension, repeat_it->n, NULL, NULL,
+				 0);
+}
+
+/* The source is looped over by an outer digit */
+static int plan_lower_loop(struct plan_it_s *plan, const_excit_t it)
+{
+	const struct loop_it_s *loop_it = (const struct loop_it_s *)it->data;
+	struct plan_it_s part;
+	int err;
+
+	err = plan_it_add_digit(plan, it->dimension, loop_it->n, NULL, NULL,
+				0);
+	if (err)
+		return err;
+	err = plan_lower_part(&part, loop_it->it);
+	if (!err)
+		err = plan_it_append(plan, it->dimension, &part,
+				     it->dimension, 0);
+	plan_it_clear(&part);
+	return err;
+}
+
+/*
+ * A source with a single affine digit indexed by an affine indexer is affine
+ * in the digits of the indexer, as long as every index is a rank of the
+ * source.
+ */
+static int plan_lower_composition(struct plan_it_s *plan, const_excit_t it)
+{
+	const struct composition_it_s *composition_it =
+	    (const struct composition_it_s *)it->data;
+	ssize_t dim = it->dimension;
+	struct plan_it_s src, indexer;
+	ssize_t lo, hi, count;
+	int err;
+
+	err = plan_lower_part(&src, composition_it->src);
+	if (err)
+		goto exit_src;
+	err = plan_lower_part(&indexer, composition_it->indexer);
+	if (err)
+		goto exit;
+	err = -EXCIT_ENOTSUP;
+	if (src.count != 1 || !plan_it_is_affine(&src) ||
+	    !plan_it_is_affine(&indexer))
+		goto exit;
+	lo = hi = indexer.base[0];
+	for (ssize_t k = 0; k < indexer.count; k++) {
+		ssize_t span = indexer.coefs[k] * (indexer.radices[k] - 1);
+
+		if (indexer.radices[k] == 0)
+			goto exit;
+		if (span < 0)
+			lo += span;
+		else
+			hi += span;
+	}
+	if (lo < 0 || hi >= src.radices[0])
+		goto exit;
+	for (ssize_t j = 0; j < dim; j++)
+		plan->base[j] = src.base[j] + src.coefs[j] * indexer.base[0];
+	for (ssize_t k = 0; k < indexer.count; k++) {
+		count = plan->count;
+		err = plan_it_add_digit(plan, dim, indexer.radices[k], NULL,
+					NULL, 0);
+		if (err)
+			goto exit;
+		for (ssize_t j = 0; plan->count > count && j < dim; j++)
+			plan->coefs[count * dim + j] =
+			    src.coefs[j] * indexer.coefs[k];
+	}
+	err = EXCIT_SUCCESS;
+exit:
+	plan_it_clear(&indexer);
+exit_src:
+	plan_it_clear(&src);
+	return err;
+}
+
+/* Offsets of an affine source are affine */
+static int plan_lower_offset(struct plan_it_s *plan, const_excit_t it)
+{
+	const struct offset_it_s *offset_it =
+	    (const struct offset_it_s *)it->data;
+	ssize_t src_dim = offset_it->src->dimension;
+	struct plan_it_s src;
+	ssize_t coef;
+	int err;
+
+	err = plan_lower_part(&src, offset_it->src);
+	if (err)
+		goto exit;
+	err = -EXCIT_ENOTSUP;
+	if (!plan_it_is_affine(&src))
+		goto exit;
+	plan->base[0] = offset_it->base;
+	for (ssize_t j = 0; j < src_dim; j++)
+		plan->base[0] += offset_it->strides[j] * src.base[j];
+	for (ssize_t k = 0; k < src.count; k++) {
+		coef = 0;
+		for (ssize_t j = 0; j < src_dim; j++)
+			coef += offset_it->strides[j] *
+			    src.coefs[k * src_dim + j];
+		err = plan_it_add_digit(plan, 1, src.radices[k], &coef, NULL,
+					0);
+		if (err)
+			goto exit;
+	}
+	err = EXCIT_SUCCESS;
+exit:
+	plan_it_clear(&src);
+	return err;
+}
+
+/*
+ * Lowers it into an empty plan. Iterators that cannot be lowered, and user
+ * iterators, become leaves. Only the root may iterate over a window of its
+ * ranks.
+ */
+static int plan_lower(struct plan_it_s *plan, const_excit_t it, int root)
+{
+	int err;
+
+	plan_it_clear(plan);
+	err = plan_it_resize(plan, it->dimension, 0);
+	if (err)
+		return err;
+	switch (it->type) {
+	case EXCIT_RANGE:
+		err = plan_lower_range(plan, it);
+		break;
+	case EXCIT_BOX:
+		err = plan_lower_box(plan, it, root);
+		break;
+	case EXCIT_PRODUCT:
+		err = plan_lower_product(plan, it, root);
+		break;
+	case EXCIT_REPEAT:
+		err = plan_lower_repeat(plan, it);
+		break;
+	case EXCIT_LOOP:
+		err = plan_lower_loop(plan, it);
+		break;
+	case EXCIT_COMPOSITION:
+		err = plan_lower_composition(plan, it);
+		break;
+	case EXCIT_OFFSET:
+		err = plan_lower_offset(plan, it);
+		break;
+	default:
+		err = -EXCIT_ENOTSUP;
+		break;
+	}
+	if (err != -EXCIT_ENOTSUP)
+		return err;
+	plan_it_clear(plan);
+	err = plan_it_resize(plan, it->dimension, 0);
+	if (err)
+		return err;
+	return plan_lower_leaf(plan, it);
+}
+
+/* Positions the plan on a rank, leaves are left just after their digit */
+static int plan_it_load(excit_t data, ssize_t rank)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	int err;
+
+	it->rank = rank;
+	if (rank >= it->end)
+		return EXCIT_SUCCESS;
+	for (ssize_t k = it->count - 1; k >= 0; k--) {
+		ssize_t q = excit_divide(it->radix_divs + k, rank);
+
+		it->digits[k] = rank - q * it->radices[k];
+		rank = q;
+	}
+	memcpy(it->cur, it->base, dim * sizeof(ssize_t));
+	for (ssize_t k = 0; k < it->count; k++) {
+		const ssize_t *coef = it->coefs + k * dim;
+
+		for (ssize_t j = 0; it->digits[k] && j < dim; j++)
+			it->cur[j] += it->digits[k] * coef[j];
+		if (!it->leaves[k])
+			continue;
+		err = excit_seek(it->leaves[k], it->digits[k]);
+		if (!err)
+			err = excit_next(it->leaves[k],
+					 it->cur + it->leaf_offsets[k]);
+		if (err)
+			return err < 0 ? err : -EXCIT_EDOM;
+	}
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Increments the digits: a single row of carries is added to the current
+ * element, and the leaves of the incremented digit and of the digits that
+ * wrapped around are moved.
+ */
+static inline int plan_it_advance(excit_t data)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t k = it->count - 1;
+	const ssize_t *carry;
+	int err;
+
+	if (++it->rank >= it->end)
+		return EXCIT_SUCCESS;
+	while (it->digits[k] == it->radices[k] - 1)
+		it->digits[k--] = 0;
+	it->digits[k]++;
+	carry = it->carries + k * dim;
+	for (ssize_t j = 0; j < dim; j++)
+		it->cur[j] += carry[j];
+	for (ssize_t l = it->last_leaf; l >= k; l--) {
+		if (!it->leaves[l])
+			continue;
+		if (l > k) {
+			err = excit_rewind(it->leaves[l]);
+			if (err)
+				return err;
+		}
+		err = excit_next(it->leaves[l], it->cur + it->leaf_offsets[l]);
+		if (err)
+			return err < 0 ? err : -EXCIT_EDOM;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+
+	*size = it->end - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_rewind(excit_t data)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+
+	return plan_it_load(data, it->first);
+}
+
+static int plan_it_seek(excit_t data, ssize_t rank)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+
+	return plan_it_load(data, it->first + rank);
+}
+
+static int plan_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_next(excit_t data, ssize_t *indexes)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	return plan_it_advance(data);
+}
+
+static int plan_it_next_batch(excit_t data, ssize_t max, ssize_t *indexes,
+			      ssize_t *produced)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t inner = it->count - 1;
+	ssize_t count = 0;
+	int err;
+
+	if (it->rank >= it->end)
+		return EXCIT_STOPIT;
+	while (count < max && it->rank < it->end) {
+		const ssize_t *coef = NULL;
+		ssize_t run = 1;
+
+		/* along the innermost digit, a single row of coefs is added */
+		if (inner >= 0 && it->last_leaf < inner) {
+			coef = it->coefs + inner * dim;
+			run = it->radices[inner] - it->digits[inner];
+			if (run > max - count)
+				run = max - count;
+			if (run > it->end - it->rank)
+				run = it->end - it->rank;
+		}
+		for (ssize_t j = 0; indexes && j < dim; j++) {
+			ssize_t *out = indexes + count * dim + j;
+			ssize_t v = it->cur[j];
+
+			*out = v;
+			for (ssize_t r = 1; r < run; r++) {
+				out += dim;
+				v += coef[j];
+				*out = v;
+			}
+		}
+		/* the last element of the run becomes current, then advances */
+		if (run > 1) {
+			for (ssize_t j = 0; j < dim; j++)
+				it->cur[j] += (run - 1) * coef[j];
+			it->digits[inner] += run - 1;
+			it->rank += run - 1;
+		}
+		err = plan_it_advance(data);
+		if (err)
+			return err;
+		count += run;
+	}
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int plan_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t rank = it->first + n;
+	int err;
+
+	if (n < 0 || rank >= it->end)
+		return -EXCIT_EDOM;
+	if (!indexes)
+		return EXCIT_SUCCESS;
+	/*
+	 * Leaves own their coordinates, which no other digit adds to, so the
+	 * digits can be applied as they are extracted, innermost first.
+	 */
+	memcpy(indexes, it->base, dim * sizeof(ssize_t));
+	for (ssize_t k = it->count - 1; k >= 0; k--) {
+		const ssize_t *coef = it->coefs + k * dim;
+		ssize_t q = excit_divide(it->radix_divs + k, rank);
+		ssize_t digit = rank - q * it->radices[k];
+
+		rank = q;
+		for (ssize_t j = 0; digit && j < dim; j++)
+			indexes[j] += digit * coef[j];
+		if (!it->leaves[k])
+			continue;
+		err = excit_nth(it->leaves[k], digit,
+				indexes + it->leaf_offsets[k]);
+		if (err)
+			return err;
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Ranks are computed by the compiled iterator */
+static int plan_it_rank(const_excit_t data, const ssize_t *indexes,
+			ssize_t *n)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+	ssize_t rank;
+	int err = excit_rank(it->tree, indexes, &rank);
+
+	if (err)
+		return err;
+	rank += it->tree_first;
+	if (rank < it->first || rank >= it->end)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+/* Parts cover contiguous windows of ranks */
+static int plan_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct plan_it_s *it = (const struct plan_it_s *)data->data;
+	ssize_t size = it->end - it->first;
+	ssize_t i;
+	int err = -EXCIT_ENOMEM;
+
+	if (size < n)
+		return -EXCIT_EDOM;
+	if (!results)
+		return EXCIT_SUCCESS;
+	for (i = 0; i < n; i++) {
+		results[i] = excit_dup(data);
+		if (!results[i])
+			goto error;
+		struct plan_it_s *res_it = (struct plan_it_s *)results[i]->data;
+
+		res_it->first = it->first + excit_split_offset(size, n, i);
+		res_it->end = it->first + excit_split_offset(size, n, i + 1);
+		err = plan_it_rewind(results[i]);
+		if (err) {
+			excit_free(results[i]);
+			goto error;
+		}
+	}
+	return EXCIT_SUCCESS;
+error:
+	while (--i >= 0)
+		excit_free(results[i]);
+	return err;
+}
+
+struct excit_func_table_s excit_plan_func_table = {
+	plan_it_alloc,
+	plan_it_free,
+	plan_it_copy,
+	plan_it_next,
+	plan_it_peek,
+	plan_it_size,
+	plan_it_rewind,
+	plan_it_split,
+	plan_it_nth,
+	plan_it_rank,
+	plan_it_pos,
+	plan_it_next_batch,
+	NULL,
+	NULL,
+	plan_it_seek,
+	NULL,
+	NULL
+};
+
+/*
+ * Computes the size and the carries of a lowered plan: incrementing digit k
+ * adds its coefficients and removes those of the inner digits, which wrap
+ * around from their last value to 0. The current element, loaded afterwards,
+ * holds the wrap-around of the inner digits meanwhile.
+ */
+static void plan_it_finalize(excit_t data)
+{
+	struct plan_it_s *it = (struct plan_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t *wrap = it->cur;
+
+	memset(wrap, 0, dim * sizeof(ssize_t));
+	it->size = 1;
+	for (ssize_t k = it->count - 1; k >= 0; k--) {
+		const ssize_t *coef = it->coefs + k * dim;
+		ssize_t *carry = it->carries + k * dim;
+
+		for (ssize_t j = 0; j < dim; j++) {
+			carry[j] = coef[j] - wrap[j];
+			wrap[j] += coef[j] * (it->radices[k] - 1);
+		}
+		excit_divisor_init(it->radix_divs + k, it->radices[k]);
+		it->size *= it->radices[k];
+		if (it->leaves[k] && it->last_leaf < k)
+			it->last_leaf = k;
+	}
+	if (it->end < 0) {
+		it->first = 0;
+		it->end = it->size;
+	}
+	it->tree_first = it->first;
+}
+
+int excit_compile(const_excit_t it, excit_t *plan)
+{
+	struct plan_it_s *plan_it;
+	excit_t result;
+	ssize_t pos;
+	int err;
+
+	if (!it || !it->func_table || !plan)
+		return -EXCIT_EINVAL;
+	result = excit_alloc(EXCIT_PLAN);
+	if (!result)
+		return -EXCIT_ENOMEM;
+	plan_it = (struct plan_it_s *)result->data;
+	err = plan_lower(plan_it, it, 1);
+	if (err)
+		goto error;
+	plan_it->tree = excit_dup(it);
+	if (!plan_it->tree) {
+		err = -EXCIT_ENOMEM;
+		goto error;
+	}
+	result->dimension = it->dimension;
+	plan_it_finalize(result);
+	/* Iterators that do not know their position are compiled rewound */
+	err = excit_pos(it, &pos);
+	if (err == EXCIT_STOPIT)
+		pos = plan_it->end - plan_it->first;
+	else if (err)
+		pos = 0;
+	err = plan_it_load(result, plan_it->first + pos);
+	if (err)
+		goto error;
+	*plan = result;
+	return EXCIT_SUCCESS;
+error:
+	excit_free(result);
+	return err;
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_PLAN_H
+#define EXCIT_PLAN_H
+
+#include "excit.h"
+#include "dev/excit.h"
+#include "divide.h"
+
+/*
+ * A rank is written as mixed-radix digits, outermost first. Each coordinate
+ * of an element is an affine function of the digits:
+ *         cur[j] = base[j] + sum(digits[k] * coefs[k * dim + j])
+ * except for the coordinates of leaves, which are computed by a subtree that
+ * could not be lowered, indexed by a single digit.
+ */
+struct plan_it_s {
+	/* Number of digits */
+	ssize_t count;
+	ssize_t *radices;
+	/* Divides by the radix of each digit */
+	struct excit_divisor_s *radix_divs;
+	ssize_t *base;
+	ssize_t *coefs;
+	/*
+	 * Change of the coordinates when digit k is incremented and the inner
+	 * digits wrap around to 0, a dim row per digit.
+	 */
+	ssize_t *carries;
+	/* Subtree owned by each digit and offset of its coordinates, or NULL */
+	excit_t *leaves;
+	ssize_t *leaf_offsets;
+	/* Innermost digit owning a leaf, -1 if there is none */
+	ssize_t last_leaf;
+	/* Digits and element of the current rank */
+	ssize_t *digits;
+	ssize_t *cur;
+	/* Rank of the current element */
+	ssize_t rank;
+	/* Window of ranks [first, end) that is iterated */
+	ssize_t first;
+	ssize_t end;
+	/* Product of the radices */
+	ssize_t size;
+	/* Copy of the compiled iterator, used to compute ranks */
+	excit_t tree;
+	/* Rank of the plan corresponding to the first rank of tree */
+	ssize_t tree_first;
+};
+
+extern struct excit_func_table_s excit_plan_func_table;
+
+#endif //EXCIT_PLAN_H
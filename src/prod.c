@@ -10,6 +10,8 @@
 #include <string.h>
 #include "dev/excit.h"
 #include "prod.h"
+#include "range.h"
+#include "box.h"
 
 static int prod_it_alloc(excit_t data)
 {
@@ -18,6 +20,65 @@ static int prod_it_alloc(excit_t data)
 	it->count = 0;
 	it->its = NULL;
 	it->buff = NULL;
+	it->cur = NULL;
+	it->stale = 0;
+	it->rank = 0;
+	it->depleted = 1;
+	it->size = 0;
+	it->first = 0;
+	it->end = 0;
+	it->sizes = NULL;
+	it->strides = NULL;
+	it->offsets = NULL;
+	it->size_divs = NULL;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Recomputes the cached factor sizes, strides and offsets. Must be called
+ * whenever a factor is added or replaced. The window is reset to the full
+ * product.
+ */
+static int prod_it_update_sizes(excit_t data)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t *sizes = realloc(it->sizes, 3 * it->count * sizeof(ssize_t));
+	struct excit_divisor_s *size_divs;
+	ssize_t offset = 0;
+
+	if (!sizes)
+		return -EXCIT_ENOMEM;
+	it->sizes = sizes;
+	size_divs = realloc(it->size_divs,
+			    it->count * sizeof(struct excit_divisor_s));
+	if (!size_divs)
+		return -EXCIT_ENOMEM;
+	it->size_divs = size_divs;
+	it->strides = sizes + it->count;
+	it->offsets = sizes + 2 * it->count;
+	for (ssize_t i = 0; i < it->count; i++) {
+		it->offsets[i] = offset;
+		offset += it->its[i]->dimension;
+	}
+	it->size = it->count ? 1 : 0;
+	it->first = 0;
+	it->end = -1;
+	for (ssize_t i = it->count - 1; i >= 0; i--) {
+		if (excit_size(it->its[i], it->sizes + i)) {
+			it->size = -1;
+			data->func_table = &excit_prod_func_table;
+			return EXCIT_SUCCESS;
+		}
+		excit_divisor_init(it->size_divs + i, it->sizes[i]);
+		it->strides[i] = it->size;
+		it->size *= it->sizes[i];
+	}
+	it->end = it->size;
+	data->func_table = it->count ? &excit_prod_unit_func_table :
+	    &excit_prod_func_table;
+	for (ssize_t i = 0; i < it->count; i++)
+		if (it->its[i]->func_table != &excit_range_unit_func_table)
+			data->func_table = &excit_prod_func_table;
 	return EXCIT_SUCCESS;
 }
 
@@ -30,6 +91,8 @@ static void prod_it_free(excit_t data)
 			excit_free(it->its[i]);
 		free(it->its);
 		free(it->buff);
+		free(it->sizes);
+		free(it->size_divs);
 	}
 }
 
@@ -41,7 +104,7 @@ static int prod_it_copy(excit_t dst, const_excit_t src)
 	result->its = (excit_t *) malloc(it->count * sizeof(excit_t));
 	if (!result->its)
 		return -EXCIT_ENOMEM;
-	result->buff = (ssize_t *) malloc(src->dimension * sizeof(ssize_t));
+	result->buff = (ssize_t *) malloc(2 * src->dimension * sizeof(ssize_t));
 	if (!result->buff){
 		free(result->its);
 		return -EXCIT_ENOMEM;
@@ -57,23 +120,51 @@ static int prod_it_copy(excit_t dst, const_excit_t src)
 		}
 	}
 	result->count = it->count;
+	result->sizes = NULL;
+	result->size_divs = NULL;
+	if (prod_it_update_sizes(dst)) {
+		i = it->count - 1;
+		goto error;
+	}
+	memcpy(result->buff, it->cur, src->dimension * sizeof(ssize_t));
+	result->cur = result->buff;
+	result->stale = 0;
+	result->rank = it->rank;
+	result->depleted = it->depleted;
+	result->first = it->first;
+	result->end = it->end;
 	return EXCIT_SUCCESS;
 error:
 	while (i >= 0) {
-		free(result->its[i]);
+		excit_free(result->its[i]);
 		i--;
 	}
 	free(result->its);
+	free(result->buff);
+	result->count = 0;
+	result->its = NULL;
+	result->buff = NULL;
 	return -EXCIT_ENOMEM;
 }
 
-static int prod_it_rewind(excit_t data)
+/*
+ * The product is an odometer: cur holds the current element and every factor
+ * has already been advanced past its own coordinate in cur. Loads the
+ * coordinates of each factor into cur from the current factor positions.
+ */
+static int prod_it_load(excit_t data)
 {
 	struct prod_it_s *it = (struct prod_it_s *)data->data;
 
+	it->depleted = 0;
+	it->stale = 0;
 	for (ssize_t i = 0; i < it->count; i++) {
-		int err = excit_rewind(it->its[i]);
+		int err = excit_next(it->its[i], it->cur + it->offsets[i]);
 
+		if (err == EXCIT_STOPIT) {
+			it->depleted = 1;
+			return EXCIT_SUCCESS;
+		}
 		if (err)
 			return err;
 	}
@@ -83,24 +174,12 @@ static int prod_it_rewind(excit_t data)
 static int prod_it_size(const_excit_t data, ssize_t *size)
 {
 	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
-	ssize_t tmp_size = 0;
 
 	if (!size)
 		return -EXCIT_EINVAL;
-	if (it->count == 0)
-		*size = 0;
-	else {
-		*size = 1;
-		for (ssize_t i = 0; i < it->count; i++) {
-			int err = excit_size(it->its[i], &tmp_size);
-
-			if (err) {
-				*size = 0;
-				return err;
-			}
-			*size *= tmp_size;
-		}
-	}
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
+	*size = it->end - it->first;
 	return EXCIT_SUCCESS;
 }
 
@@ -115,20 +194,19 @@ static int prod_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
 		return -EXCIT_EDOM;
 	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
 
+	n += it->first;
 	if (indexes) {
-		ssize_t subsize = 0;
 		ssize_t offset = data->dimension;
 
 		for (ssize_t i = it->count - 1; i >= 0; i--) {
+			ssize_t q = excit_divide(it->size_divs + i, n);
+
 			offset -= it->its[i]->dimension;
-			err = excit_size(it->its[i], &subsize);
-			if (err)
-				return err;
-			err = excit_nth(it->its[i], n % subsize,
+			err = excit_nth(it->its[i], n - q * it->sizes[i],
 					indexes + offset);
 			if (err)
 				return err;
-			n /= subsize;
+			n = q;
 		}
 	}
 	return EXCIT_SUCCESS;
@@ -141,99 +219,501 @@ static int prod_it_rank(const_excit_t data, const ssize_t *indexes,
 
 	if (it->count == 0)
 		return -EXCIT_EINVAL;
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
 	ssize_t offset = 0;
 	ssize_t product = 0;
 	ssize_t inner_n;
-	ssize_t subsize;
 
 	for (ssize_t i = 0; i < it->count; i++) {
 		int err = excit_rank(it->its[i], indexes + offset, &inner_n);
 		if (err)
 			return err;
-		err = excit_size(it->its[i], &subsize);
-		if (err)
-			return err;
-		product *= subsize;
-		product += inner_n;
+		product += inner_n * it->strides[i];
 		offset += it->its[i]->dimension;
 	}
+	if (product < it->first || product >= it->end)
+		return -EXCIT_EINVAL;
 	if (n)
-		*n = product;
+		*n = product - it->first;
 	return EXCIT_SUCCESS;
 }
 
-static int prod_it_pos(const_excit_t data, ssize_t *n)
+static int prod_it_nth_batch(const_excit_t data, ssize_t count,
+			     const ssize_t *ranks, ssize_t *indexes)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+	ssize_t size;
+	int err = prod_it_size(data, &size);
+
+	if (err)
+		return err;
+	for (ssize_t k = 0; k < count; k++)
+		if (ranks[k] < 0 || ranks[k] >= size)
+			return -EXCIT_EDOM;
+	if (!indexes)
+		return EXCIT_SUCCESS;
+
+	ssize_t max_dim = 0;
+
+	for (ssize_t i = 0; i < it->count; i++)
+		if (it->its[i]->dimension > max_dim)
+			max_dim = it->its[i]->dimension;
+
+	ssize_t *q = malloc(count * (2 + max_dim) * sizeof(ssize_t));
+
+	if (!q)
+		return -EXCIT_ENOMEM;
+	ssize_t *r = q + count;
+	ssize_t *buf = r + count;
+	ssize_t offset = data->dimension;
+
+	for (ssize_t k = 0; k < count; k++)
+		q[k] = ranks[k] + it->first;
+	for (ssize_t i = it->count - 1; i >= 0; i--) {
+		ssize_t subsize = it->sizes[i];
+		ssize_t dim = it->its[i]->dimension;
+
+		offset -= dim;
+		for (ssize_t k = 0; k < count; k++) {
+			ssize_t quotient = excit_divide(it->size_divs + i, q[k]);
+
+			r[k] = q[k] - quotient * subsize;
+			q[k] = quotient;
+		}
+		err = excit_nth_batch(it->its[i], count, r, buf);
+		if (err)
+			goto exit;
+		for (ssize_t k = 0; k < count; k++)
+			for (ssize_t j = 0; j < dim; j++)
+				indexes[k * data->dimension + offset + j] =
+				    buf[k * dim + j];
+	}
+exit:
+	free(q);
+	return err;
+}
+
+static int prod_it_rank_batch(const_excit_t data, ssize_t count,
+			      const ssize_t *indexes, ssize_t *ranks)
 {
 	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
 
 	if (it->count == 0)
 		return -EXCIT_EINVAL;
-	ssize_t product = 0;
-	ssize_t inner_n;
-	ssize_t subsize;
+	if (it->size < 0)
+		return -EXCIT_ENOTSUP;
+
+	ssize_t max_dim = 0;
+
+	for (ssize_t i = 0; i < it->count; i++)
+		if (it->its[i]->dimension > max_dim)
+			max_dim = it->its[i]->dimension;
 
+	ssize_t *acc = malloc(count * (2 + max_dim) * sizeof(ssize_t));
+
+	if (!acc)
+		return -EXCIT_ENOMEM;
+	ssize_t *r = acc + count;
+	ssize_t *buf = r + count;
+	ssize_t offset = 0;
+	int err = EXCIT_SUCCESS;
+
+	for (ssize_t k = 0; k < count; k++)
+		acc[k] = 0;
 	for (ssize_t i = 0; i < it->count; i++) {
-		int err = excit_pos(it->its[i], &inner_n);
+		ssize_t stride = it->strides[i];
+		ssize_t dim = it->its[i]->dimension;
 
+		for (ssize_t k = 0; k < count; k++)
+			for (ssize_t j = 0; j < dim; j++)
+				buf[k * dim + j] =
+				    indexes[k * data->dimension + offset + j];
+		err = excit_rank_batch(it->its[i], count, buf, r);
+		if (err)
+			goto exit;
+		for (ssize_t k = 0; k < count; k++)
+			acc[k] += r[k] * stride;
+		offset += dim;
+	}
+	for (ssize_t k = 0; k < count; k++)
+		if (acc[k] < it->first || acc[k] >= it->end) {
+			err = -EXCIT_EINVAL;
+			goto exit;
+		}
+	if (ranks)
+		for (ssize_t k = 0; k < count; k++)
+			ranks[k] = acc[k] - it->first;
+exit:
+	free(acc);
+	return err;
+}
+
+static int prod_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->rank - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int prod_it_seek(excit_t data, ssize_t rank)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t size;
+	int err = prod_it_size(data, &size);
+
+	if (err)
+		return err;
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (rank == size) {
+		it->rank = it->end;
+		it->depleted = 1;
+		return EXCIT_SUCCESS;
+	}
+	rank += it->first;
+	it->rank = rank;
+	for (ssize_t i = it->count - 1; i >= 0; i--) {
+		ssize_t q = excit_divide(it->size_divs + i, rank);
+
+		err = excit_seek(it->its[i], rank - q * it->sizes[i]);
 		if (err)
 			return err;
-		err = excit_size(it->its[i], &subsize);
+		rank = q;
+	}
+	return prod_it_load(data);
+}
+
+static int prod_it_rewind(excit_t data)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->first != 0)
+		return prod_it_seek(data, 0);
+	for (ssize_t i = 0; i < it->count; i++) {
+		int err = excit_rewind(it->its[i]);
+
 		if (err)
 			return err;
-		product *= subsize;
-		product += inner_n;
 	}
-	if (n)
-		*n = product;
+	it->rank = 0;
+	return prod_it_load(data);
+}
+
+static int prod_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
 	return EXCIT_SUCCESS;
 }
 
-static inline int prod_it_peeknext_helper(const_excit_t data, ssize_t *indexes,
-					  int next)
+/*
+ * Moves the odometer to the next element: only the innermost factor is
+ * incremented, outer factors are incremented only when inner ones wrap around.
+ * The next element is built in the other half of buff: incremented factors
+ * write their coordinates directly, and only the coordinates that changed
+ * since that half was last current are copied over.
+ */
+static inline int prod_it_advance(excit_t data)
 {
 	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t *next = it->cur == it->buff ? it->buff + data->dimension :
+	    it->buff;
+	ssize_t i = it->count - 1;
 	int err;
-	int looped;
-	ssize_t i;
-	ssize_t *next_indexes;
-	ssize_t offset = data->dimension;
 
-	if (it->count == 0)
-		return -EXCIT_EINVAL;
-	looped = next;
-	for (i = it->count - 1; i > 0; i--) {
-		offset -= it->its[i]->dimension;
-		next_indexes = it->buff + offset;
-		if (looped)
-			err = excit_cyclic_next(it->its[i], next_indexes,
-						&looped);
-		else
-			err = excit_peek(it->its[i], next_indexes);
+	if (++it->rank == it->end) {
+		it->depleted = 1;
+		return EXCIT_SUCCESS;
+	}
+	while ((err = excit_next(it->its[i], next + it->offsets[i]))
+	       == EXCIT_STOPIT) {
+		if (i == 0) {
+			it->depleted = 1;
+			return EXCIT_SUCCESS;
+		}
+		err = excit_rewind(it->its[i]);
 		if (err)
 			return err;
+		err = excit_next(it->its[i], next + it->offsets[i]);
+		if (err)
+			return err < 0 ? err : -EXCIT_EINVAL;
+		i--;
 	}
-	offset -= it->its[i]->dimension;
-	next_indexes = it->buff + offset;
-	if (looped)
-		err = excit_next(it->its[0], next_indexes);
-	else
-		err = excit_peek(it->its[0], next_indexes);
 	if (err)
 		return err;
+	if (it->stale < it->offsets[i])
+		memcpy(next + it->stale, it->cur + it->stale,
+		       (it->offsets[i] - it->stale) * sizeof(ssize_t));
+	it->cur = next;
+	it->stale = it->offsets[i];
+	return EXCIT_SUCCESS;
+}
+
+static int prod_it_next(excit_t data, ssize_t *indexes)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	return prod_it_advance(data);
+}
+
+static int prod_it_next_delta(excit_t data, ssize_t *indexes,
+			      ssize_t *first_changed_dim)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	*first_changed_dim = it->stale;
+	return prod_it_advance(data);
+}
+
+static int prod_it_next_ref(excit_t data, const ssize_t **tuple)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	*tuple = it->cur;
+	return prod_it_advance(data);
+}
+
+static int prod_it_next_batch(excit_t data, ssize_t max, ssize_t *indexes,
+			      ssize_t *produced)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t count;
 
-	if(indexes)
-		memcpy(indexes, it->buff, data->dimension * sizeof(ssize_t)); 
+	if (it->count == 0)
+		return -EXCIT_EINVAL;
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	for (count = 0; count < max && !it->depleted; count++) {
+		int err;
+
+		if (indexes)
+			memcpy(indexes + count * data->dimension, it->cur,
+			       data->dimension * sizeof(ssize_t));
+		err = prod_it_advance(data);
+		if (err)
+			return err;
+	}
+	*produced = count;
 	return EXCIT_SUCCESS;
 }
 
-static int prod_it_peek(const_excit_t data, ssize_t *indexes)
+/*
+ * Products of ranges with a step of 1 use their own function table, which
+ * reads and increments the ranges in place instead of going through their
+ * function table. Each range has a single coordinate, so the offset of a
+ * factor is its index.
+ */
+static inline int prod_unit_it_advance(excit_t data)
 {
-	return prod_it_peeknext_helper(data, indexes, 0);
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t *next = it->cur == it->buff ? it->buff + data->dimension :
+	    it->buff;
+	ssize_t i = it->count - 1;
+
+	if (++it->rank == it->end) {
+		it->depleted = 1;
+		return EXCIT_SUCCESS;
+	}
+	for (;; i--) {
+		struct range_it_s *range_it =
+		    (struct range_it_s *)it->its[i]->data;
+
+		if (range_it->v <= range_it->last) {
+			next[i] = range_it->v++;
+			break;
+		}
+		if (i == 0) {
+			it->depleted = 1;
+			return EXCIT_SUCCESS;
+		}
+		next[i] = range_it->first;
+		range_it->v = range_it->first + 1;
+	}
+	if (it->stale < i)
+		memcpy(next + it->stale, it->cur + it->stale,
+		       (i - it->stale) * sizeof(ssize_t));
+	it->cur = next;
+	it->stale = i;
+	return EXCIT_SUCCESS;
 }
 
-static int prod_it_next(excit_t data, ssize_t *indexes)
+static int prod_unit_it_next(excit_t data, ssize_t *indexes)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	return prod_unit_it_advance(data);
+}
+
+static int prod_unit_it_next_delta(excit_t data, ssize_t *indexes,
+				   ssize_t *first_changed_dim)
 {
-	return prod_it_peeknext_helper(data, indexes, 1);
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	if (indexes)
+		memcpy(indexes, it->cur, data->dimension * sizeof(ssize_t));
+	*first_changed_dim = it->stale;
+	return prod_unit_it_advance(data);
+}
+
+static int prod_unit_it_next_ref(excit_t data, const ssize_t **tuple)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	*tuple = it->cur;
+	return prod_unit_it_advance(data);
+}
+
+static int prod_unit_it_next_batch(excit_t data, ssize_t max,
+				   ssize_t *indexes, ssize_t *produced)
+{
+	struct prod_it_s *it = (struct prod_it_s *)data->data;
+	ssize_t count;
+
+	if (it->depleted)
+		return EXCIT_STOPIT;
+	for (count = 0; count < max && !it->depleted; count++) {
+		if (indexes)
+			memcpy(indexes + count * data->dimension, it->cur,
+			       data->dimension * sizeof(ssize_t));
+		prod_unit_it_advance(data);
+	}
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int prod_unit_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+
+	if (n < 0 || n >= it->end - it->first)
+		return -EXCIT_EDOM;
+	n += it->first;
+	if (indexes)
+		for (ssize_t i = it->count - 1; i >= 0; i--) {
+			const struct range_it_s *range_it =
+			    (const struct range_it_s *)it->its[i]->data;
+			ssize_t q = excit_divide(it->size_divs + i, n);
+
+			indexes[i] = range_it->first + n - q * it->sizes[i];
+			n = q;
+		}
+	return EXCIT_SUCCESS;
+}
+
+static int prod_unit_it_rank(const_excit_t data, const ssize_t *indexes,
+			     ssize_t *n)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+	ssize_t product = 0;
+
+	for (ssize_t i = 0; i < it->count; i++) {
+		const struct range_it_s *range_it =
+		    (const struct range_it_s *)it->its[i]->data;
+
+		if (indexes[i] < range_it->first ||
+		    indexes[i] > range_it->last)
+			return -EXCIT_EINVAL;
+		product += (indexes[i] - range_it->first) * it->strides[i];
+	}
+	if (product < it->first || product >= it->end)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = product - it->first;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Splits a product into contiguous slices of its ranks; each slice iterates as
+ * a product over its window.
+ */
+static int prod_it_split_ranks(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+	ssize_t size = it->end - it->first;
+	ssize_t end = it->end;
+	ssize_t i;
+	int err;
+
+	for (i = n - 1; i >= 0; i--) {
+		ssize_t block_size = size / (i + 1);
+
+		results[i] = excit_dup(data);
+		if (!results[i]) {
+			err = -EXCIT_ENOMEM;
+			goto error;
+		}
+		struct prod_it_s *res_it = (struct prod_it_s *)results[i]->data;
+
+		res_it->first = end - block_size;
+		res_it->end = end;
+		err = prod_it_rewind(results[i]);
+		if (err) {
+			excit_free(results[i]);
+			goto error;
+		}
+		end -= block_size;
+		size -= block_size;
+	}
+	return EXCIT_SUCCESS;
+error:
+	for (i += 1; i < n; i++)
+		excit_free(results[i]);
+	return err;
+}
+
+static int prod_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct prod_it_s *it = (const struct prod_it_s *)data->data;
+	ssize_t size;
+	int err = prod_it_size(data, &size);
+
+	if (err)
+		return err;
+	if (size < n)
+		return -EXCIT_EDOM;
+	if (!results)
+		return EXCIT_SUCCESS;
+	/* Cut along the outermost factor when it yields balanced parts */
+	if (it->first == 0 && it->end == it->size && it->sizes[0] % n == 0)
+		return excit_product_split_dim(data, 0, n, results);
+	return prod_it_split_ranks(data, n, results);
 }
 
 int excit_product_count(const_excit_t it, ssize_t *count)
@@ -260,6 +740,9 @@ int excit_product_split_dim(const_excit_t it, ssize_t dim, ssize_t n,
 		return -EXCIT_EDOM;
 	struct prod_it_s *prod_it = (struct prod_it_s *)it->data;
 
+	if (prod_it->first != 0 || prod_it->end != prod_it->size)
+		return -EXCIT_ENOTSUP;
+
 	err = excit_split(prod_it->its[dim], n, results);
 	if (err)
 		return err;
@@ -269,7 +752,7 @@ int excit_product_split_dim(const_excit_t it, ssize_t dim, ssize_t n,
 		excit_t tmp = results[i];
 
 		results[i] = excit_dup(it);
-		if (!tmp) {
+		if (!results[i]) {
 			excit_free(tmp);
 			err = -EXCIT_ENOMEM;
 			goto error;
@@ -278,6 +761,12 @@ int excit_product_split_dim(const_excit_t it, ssize_t dim, ssize_t n,
 		    (struct prod_it_s *)results[i]->data;
 		excit_free(new_prod_it->its[dim]);
 		new_prod_it->its[dim] = tmp;
+		err = prod_it_update_sizes(results[i]);
+		if (err)
+			goto error;
+		err = prod_it_rewind(results[i]);
+		if (err)
+			goto error;
 	}
 	return EXCIT_SUCCESS;
 error:
@@ -286,6 +775,244 @@ error:
 	return err;
 }
 
+static int prod_it_split_grid(const_excit_t it, ssize_t dim,
+			      const ssize_t *parts_per_dim, excit_t *results,
+			      ssize_t *produced)
+{
+	const struct prod_it_s *prod_it = (const struct prod_it_s *)it->data;
+	excit_t *blocks;
+	ssize_t stride = 1;
+	int err;
+
+	if (dim == prod_it->count) {
+		results[0] = excit_dup(it);
+		if (!results[0])
+			return -EXCIT_ENOMEM;
+		(*produced)++;
+		return EXCIT_SUCCESS;
+	}
+	if (parts_per_dim[dim] == 1)
+		return prod_it_split_grid(it, dim + 1, parts_per_dim, results,
+					  produced);
+	for (ssize_t i = dim + 1; i < prod_it->count; i++)
+		stride *= parts_per_dim[i];
+	blocks = (excit_t *)malloc(parts_per_dim[dim] * sizeof(excit_t));
+	if (!blocks)
+		return -EXCIT_ENOMEM;
+	err = excit_product_split_dim(it, dim, parts_per_dim[dim], blocks);
+	if (err)
+		goto error;
+	for (ssize_t i = 0; i < parts_per_dim[dim]; i++) {
+		if (!err)
+			err = prod_it_split_grid(blocks[i], dim + 1,
+						 parts_per_dim,
+						 results + i * stride,
+						 produced);
+		excit_free(blocks[i]);
+	}
+error:
+	free(blocks);
+	return err;
+}
+
+int excit_product_split_grid(const_excit_t it, const ssize_t *parts_per_dim,
+			     excit_t *results)
+{
+	if (!it || it->type != EXCIT_PRODUCT || !parts_per_dim)
+		return -EXCIT_EINVAL;
+	const struct prod_it_s *prod_it = (const struct prod_it_s *)it->data;
+	ssize_t produced = 0;
+	int err;
+
+	if (prod_it->count == 0)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; i < prod_it->count; i++) {
+		err = excit_product_split_dim(it, i, parts_per_dim[i], NULL);
+		if (err)
+			return err;
+	}
+	if (!results)
+		return EXCIT_SUCCESS;
+	err = prod_it_split_grid(it, 0, parts_per_dim, results, &produced);
+	if (err) {
+		/* blocks are produced in order */
+		for (ssize_t i = 0; i < produced; i++)
+			excit_free(results[i]);
+	}
+	return err;
+}
+
+int excit_product_split_grid_dims(const_excit_t it, ssize_t n,
+				  ssize_t *parts_per_dim)
+{
+	if (!it || it->type != EXCIT_PRODUCT || !parts_per_dim)
+		return -EXCIT_EINVAL;
+	const struct prod_it_s *prod_it = (const struct prod_it_s *)it->data;
+	ssize_t factors[8 * sizeof(ssize_t)];
+	ssize_t nfactors = 0;
+
+	if (prod_it->count == 0 || prod_it->size < 0)
+		return -EXCIT_EINVAL;
+	if (n <= 0 || n > prod_it->size)
+		return -EXCIT_EDOM;
+	for (ssize_t p = 2; p * p <= n; p++)
+		while (n % p == 0) {
+			factors[nfactors++] = p;
+			n /= p;
+		}
+	if (n > 1)
+		factors[nfactors++] = n;
+	for (ssize_t i = 0; i < prod_it->count; i++)
+		parts_per_dim[i] = 1;
+	/*
+	 * Hand out prime factors, largest first, to the iterator whose blocks
+	 * are currently the longest and can still be cut.
+	 */
+	for (ssize_t f = nfactors - 1; f >= 0; f--) {
+		ssize_t best = -1;
+
+		for (ssize_t i = 0; i < prod_it->count; i++) {
+			if (parts_per_dim[i] * factors[f] > prod_it->sizes[i])
+				continue;
+			if (best < 0 ||
+			    prod_it->sizes[i] * parts_per_dim[best] >
+			    prod_it->sizes[best] * parts_per_dim[i])
+				best = i;
+		}
+		if (best < 0)
+			return -EXCIT_EDOM;
+		parts_per_dim[best] *= factors[f];
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Whether a factor can be merged into a box: a range or a whole box */
+static int prod_it_is_boxed(const_excit_t it)
+{
+	const struct box_it_s *box_it = (const struct box_it_s *)it->data;
+
+	if (it->type == EXCIT_RANGE)
+		return 1;
+	if (it->type != EXCIT_BOX)
+		return 0;
+	return box_it->first == 0 && box_it->end == box_it->size;
+}
+
+/* Returns the end of the run of factors merged into a box starting at i */
+static ssize_t prod_it_box_run(const struct prod_it_s *it, ssize_t i)
+{
+	ssize_t j = i + 1;
+
+	if (prod_it_is_boxed(it->its[i]))
+		while (j < it->count && prod_it_is_boxed(it->its[j]))
+			j++;
+	return j;
+}
+
+/* Builds a box iterating over the same elements as a run of factors */
+static excit_t prod_it_run_to_box(excit_t *its, ssize_t n)
+{
+	ssize_t dim = 0, k = 0;
+	ssize_t *bounds;
+	excit_t box = NULL;
+
+	for (ssize_t i = 0; i < n; i++)
+		dim += its[i]->dimension;
+	bounds = malloc(3 * dim * sizeof(ssize_t));
+	if (!bounds)
+		return NULL;
+	for (ssize_t i = 0; i < n; i++) {
+		if (its[i]->type == EXCIT_RANGE) {
+			const struct range_it_s *range_it =
+			    (const struct range_it_s *)its[i]->data;
+
+			bounds[k] = range_it->first;
+			bounds[dim + k] = range_it->last;
+			bounds[2 * dim + k] = range_it->step;
+			k++;
+			continue;
+		}
+		const struct box_it_s *box_it =
+		    (const struct box_it_s *)its[i]->data;
+
+		for (ssize_t j = 0; j < its[i]->dimension; j++, k++) {
+			bounds[k] = box_it->lower[j];
+			bounds[dim + k] = box_it->upper[j];
+			bounds[2 * dim + k] = box_it->step[j];
+		}
+	}
+	box = excit_alloc(EXCIT_BOX);
+	if (box && excit_box_init(box, dim, bounds, bounds + dim,
+				  bounds + 2 * dim)) {
+		excit_free(box);
+		box = NULL;
+	}
+	free(bounds);
+	return box;
+}
+
+int excit_product_collapse(excit_t it)
+{
+	if (!it || it->type != EXCIT_PRODUCT || !it->data)
+		return -EXCIT_EINVAL;
+
+	struct prod_it_s *prod_it = (struct prod_it_s *)it->data;
+	ssize_t first = prod_it->first;
+	ssize_t end = prod_it->end;
+	ssize_t pos = prod_it->rank - first;
+	ssize_t count = 0;
+	excit_t *its;
+	int err;
+
+	if (prod_it->count == 0)
+		return -EXCIT_EINVAL;
+	if (prod_it->size < 0)
+		return -EXCIT_ENOTSUP;
+	its = malloc(prod_it->count * sizeof(excit_t));
+	if (!its)
+		return -EXCIT_ENOMEM;
+	for (ssize_t i = 0, j; i < prod_it->count; i = j) {
+		j = prod_it_box_run(prod_it, i);
+		if (j - i == 1) {
+			its[count++] = prod_it->its[i];
+			continue;
+		}
+		its[count] = prod_it_run_to_box(prod_it->its + i, j - i);
+		if (!its[count])
+			goto error;
+		count++;
+	}
+	/* Boxes replace the runs of factors they were built from */
+	for (ssize_t i = 0, j; i < prod_it->count; i = j) {
+		j = prod_it_box_run(prod_it, i);
+		if (j - i > 1)
+			for (ssize_t k = i; k < j; k++)
+				excit_free(prod_it->its[k]);
+	}
+	free(prod_it->its);
+	prod_it->its = its;
+	prod_it->count = count;
+	err = prod_it_update_sizes(it);
+	if (err)
+		return err;
+	prod_it->first = first;
+	prod_it->end = end;
+	if (prod_it->depleted) {
+		prod_it->rank = end;
+		return EXCIT_SUCCESS;
+	}
+	return prod_it_seek(it, pos);
+error:
+	/* Only free the boxes built so far, other factors are still owned */
+	for (ssize_t i = 0, j, k = 0; k < count; i = j, k++) {
+		j = prod_it_box_run(prod_it, i);
+		if (j - i > 1)
+			excit_free(its[k]);
+	}
+	free(its);
+	return -EXCIT_ENOMEM;
+}
+
 int excit_product_add_copy(excit_t it, excit_t added_it)
 {
 	int err = 0;
@@ -316,26 +1043,54 @@ int excit_product_add(excit_t it, excit_t added_it)
 
 	if (!new_its)
 		return -EXCIT_ENOMEM;
+	prod_it->its = new_its;
+
+	/* Coordinates move to the first half, the second one grows with it */
+	if (prod_it->cur && prod_it->cur != prod_it->buff)
+		memcpy(prod_it->buff, prod_it->cur,
+		       it->dimension * sizeof(ssize_t));
+	prod_it->cur = prod_it->buff;
 
 	ssize_t *new_buff =
 		realloc(prod_it->buff,
-			(added_it->dimension + it->dimension) * sizeof(ssize_t));
+			2 * (added_it->dimension + it->dimension) *
+			sizeof(ssize_t));
 
-	if (!new_buff){
-	        err = -EXCIT_ENOMEM;
-		goto exit_with_new_its;
-	}
-	
-	prod_it->its = new_its;
+	if (!new_buff)
+		return -EXCIT_ENOMEM;
 	prod_it->buff = new_buff;
+	prod_it->cur = new_buff;
+	prod_it->stale = 0;
 	prod_it->its[prod_it->count] = added_it;
 	prod_it->count = mew_count;
 	it->dimension += added_it->dimension;
-	return EXCIT_SUCCESS;
+	err = prod_it_update_sizes(it);
+	if (err) {
+		prod_it->count--;
+		it->dimension -= added_it->dimension;
+		return err;
+	}
+	if (mew_count > 1 && prod_it->depleted)
+		return EXCIT_SUCCESS;
 
- exit_with_new_its:
-	free(new_its);
-	return err;
+	/* The added factor becomes the innermost digit of the odometer */
+	ssize_t last = mew_count - 1;
+	ssize_t pos = 0;
+
+	if (mew_count == 1 || prod_it->size < 0)
+		prod_it->rank = 0;
+	else {
+		if (excit_pos(added_it, &pos))
+			pos = 0;
+		prod_it->rank = prod_it->rank * prod_it->sizes[last] + pos;
+	}
+	prod_it->depleted = 0;
+	err = excit_next(added_it, prod_it->cur + prod_it->offsets[last]);
+	if (err == EXCIT_STOPIT)
+		prod_it->depleted = 1;
+	else if (err)
+		return err;
+	return EXCIT_SUCCESS;
 }
 
 struct excit_func_table_s excit_prod_func_table = {
@@ -346,8 +1101,34 @@ struct excit_func_table_s excit_prod_func_table = {
 	prod_it_peek,
 	prod_it_size,
 	prod_it_rewind,
-	NULL,
+	prod_it_split,
 	prod_it_nth,
 	prod_it_rank,
-	prod_it_pos
+	prod_it_pos,
+	prod_it_next_batch,
+	prod_it_nth_batch,
+	prod_it_rank_batch,
+	prod_it_seek,
+	prod_it_next_ref,
+	prod_it_next_delta
+};
+
+struct excit_func_table_s excit_prod_unit_func_table = {
+	prod_it_alloc,
+	prod_it_free,
+	prod_it_copy,
+	prod_unit_it_next,
+	prod_it_peek,
+	prod_it_size,
+	prod_it_rewind,
+	prod_it_split,
+	prod_unit_it_nth,
+	prod_unit_it_rank,
+	prod_it_pos,
+	prod_unit_it_next_batch,
+	prod_it_nth_batch,
+	prod_it_rank_batch,
+	prod_it_seek,
+	prod_unit_it_next_ref,
+	prod_unit_it_next_delta
 };
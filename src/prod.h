@@ -12,14 +12,49 @@
 
 #include "excit.h"
 #include "dev/excit.h"
+#include "divide.h"
 
 struct prod_it_s {
 	ssize_t count;
+	/*
+	 * Two halves holding consecutive elements, cur points to the current
+	 * one. Advancing writes the next element into the other half, so the
+	 * element returned by excit_next_ref() survives the increment.
+	 */
 	ssize_t* buff;
+	ssize_t *cur;
+	/*
+	 * First coordinate from which the other half may differ from cur,
+	 * which is also the first coordinate of cur that may differ from the
+	 * previous element.
+	 */
+	ssize_t stale;
 	excit_t *its;
+	/* Rank of the current element, stored in buff */
+	ssize_t rank;
+	/* Whether the iteration space is depleted */
+	int depleted;
+	/* Cached total size, -1 if a factor does not support size */
+	ssize_t size;
+	/*
+	 * Window of ranks [first, end) of the full product that is iterated,
+	 * products obtained through a split only cover a slice of the space.
+	 */
+	ssize_t first;
+	ssize_t end;
+	/* Cached size of each factor */
+	ssize_t *sizes;
+	/* Mixed-radix stride of each factor, i.e., product of inner sizes */
+	ssize_t *strides;
+	/* Divides by the size of each factor */
+	struct excit_divisor_s *size_divs;
+	/* Offset of the coordinates of each factor in the product */
+	ssize_t *offsets;
 };
 
 extern struct excit_func_table_s excit_prod_func_table;
+/* Products of ranges with a step of 1 */
+extern struct excit_func_table_s excit_prod_unit_func_table;
 
 #endif //EXCIT_PROD_H
 
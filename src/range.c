@@ -18,6 +18,7 @@ static int range_it_alloc(excit_t data)
 	it->first = 0;
 	it->last = -1;
 	it->step = 1;
+	excit_divisor_init(&it->step_div, 1);
 	return EXCIT_SUCCESS;
 }
 
@@ -35,6 +36,7 @@ static int range_it_copy(excit_t ddst, const_excit_t dsrc)
 	dst->first = src->first;
 	dst->last = src->last;
 	dst->step = src->step;
+	dst->step_div = src->step_div;
 	return EXCIT_SUCCESS;
 }
 
@@ -48,7 +50,7 @@ static int range_it_rewind(excit_t data)
 
 static int range_it_peek(const_excit_t data, ssize_t *val)
 {
-	struct range_it_s *it = (struct range_it_s *)data->data;
+	const struct range_it_s *it = (const struct range_it_s *)data->data;
 
 	if (it->step < 0) {
 		if (it->v < it->last)
@@ -74,6 +76,52 @@ static int range_it_next(excit_t data, ssize_t *val)
 	return EXCIT_SUCCESS;
 }
 
+static int range_it_next_batch(excit_t data, ssize_t max, ssize_t *vals,
+			       ssize_t *produced)
+{
+	struct range_it_s *it = (struct range_it_s *)data->data;
+	ssize_t count;
+
+	if (it->step < 0) {
+		if (it->v < it->last)
+			return EXCIT_STOPIT;
+		count = 1 + excit_divide(&it->step_div, it->v - it->last);
+	} else if (it->step > 0) {
+		if (it->v > it->last)
+			return EXCIT_STOPIT;
+		count = 1 + excit_divide(&it->step_div, it->last - it->v);
+	} else
+		return -EXCIT_EINVAL;
+	if (count > max)
+		count = max;
+	if (vals) {
+		ssize_t v = it->v;
+		ssize_t step = it->step;
+
+		for (ssize_t i = 0; i < count; i++, v += step)
+			vals[i] = v;
+	}
+	it->v += count * it->step;
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Returns the number of steps from first to val, or -1 if val is not on the
+ * range.
+ */
+static inline ssize_t range_it_offset(const struct range_it_s *it,
+				      ssize_t val)
+{
+	ssize_t diff = it->step > 0 ? val - it->first : it->first - val;
+	ssize_t pos;
+
+	if (diff < 0)
+		return -1;
+	pos = excit_divide(&it->step_div, diff);
+	return pos * it->step_div.d == diff ? pos : -1;
+}
+
 static int range_it_size(const_excit_t data, ssize_t *size)
 {
 	const struct range_it_s *it = (struct range_it_s *)data->data;
@@ -82,12 +130,14 @@ static int range_it_size(const_excit_t data, ssize_t *size)
 		if (it->first < it->last)
 			*size = 0;
 		else
-			*size = 1 + (it->first - it->last) / (-it->step);
+			*size = 1 + excit_divide(&it->step_div,
+						 it->first - it->last);
 	else if (it->step > 0)
 		if (it->first > it->last)
 			*size = 0;
 		else
-			*size = 1 + (it->last - it->first) / (it->step);
+			*size = 1 + excit_divide(&it->step_div,
+						 it->last - it->first);
 	else
 		return -EXCIT_EINVAL;
 	return EXCIT_SUCCESS;
@@ -117,15 +167,58 @@ static int range_it_rank(const_excit_t data, const ssize_t *val, ssize_t *n)
 	if (err)
 		return err;
 	const struct range_it_s *it = (struct range_it_s *)data->data;
-	ssize_t pos = (*val - it->first) / it->step;
+	ssize_t pos = range_it_offset(it, *val);
 
-	if (pos < 0 || pos >= size || it->first + pos * it->step != *val)
+	if (pos < 0 || pos >= size)
 		return -EXCIT_EINVAL;
 	if (n)
 		*n = pos;
 	return EXCIT_SUCCESS;
 }
 
+static int range_it_nth_batch(const_excit_t data, ssize_t count,
+			      const ssize_t *ranks, ssize_t *vals)
+{
+	ssize_t size;
+	int err = range_it_size(data, &size);
+
+	if (err)
+		return err;
+	for (ssize_t i = 0; i < count; i++)
+		if (ranks[i] < 0 || ranks[i] >= size)
+			return -EXCIT_EDOM;
+	if (vals) {
+		const struct range_it_s *it = (struct range_it_s *)data->data;
+		ssize_t first = it->first;
+		ssize_t step = it->step;
+
+		for (ssize_t i = 0; i < count; i++)
+			vals[i] = first + ranks[i] * step;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int range_it_rank_batch(const_excit_t data, ssize_t count,
+			       const ssize_t *vals, ssize_t *ranks)
+{
+	ssize_t size;
+	int err = range_it_size(data, &size);
+
+	if (err)
+		return err;
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	for (ssize_t i = 0; i < count; i++) {
+		ssize_t pos = range_it_offset(it, vals[i]);
+
+		if (pos < 0 || pos >= size)
+			return -EXCIT_EINVAL;
+		if (ranks)
+			ranks[i] = pos;
+	}
+	return EXCIT_SUCCESS;
+}
+
 static int range_it_pos(const_excit_t data, ssize_t *n)
 {
 	ssize_t val;
@@ -136,7 +229,15 @@ static int range_it_pos(const_excit_t data, ssize_t *n)
 	const struct range_it_s *it = (struct range_it_s *)data->data;
 
 	if (n)
-		*n = (val - it->first) / it->step;
+		*n = range_it_offset(it, val);
+	return EXCIT_SUCCESS;
+}
+
+static int range_it_seek(excit_t data, ssize_t rank)
+{
+	struct range_it_s *it = (struct range_it_s *)data->data;
+
+	it->v = it->first + rank * it->step;
 	return EXCIT_SUCCESS;
 }
 
@@ -183,6 +284,137 @@ error:
 	return err;
 }
 
+/*
+ * Ranges with a step of 1, the most common ones, use their own function table
+ * with neither sign checks nor divisions.
+ */
+static int range_unit_it_peek(const_excit_t data, ssize_t *val)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	if (it->v > it->last)
+		return EXCIT_STOPIT;
+	if (val)
+		*val = it->v;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_next(excit_t data, ssize_t *val)
+{
+	struct range_it_s *it = (struct range_it_s *)data->data;
+
+	if (it->v > it->last)
+		return EXCIT_STOPIT;
+	if (val)
+		*val = it->v;
+	it->v++;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_next_batch(excit_t data, ssize_t max, ssize_t *vals,
+				    ssize_t *produced)
+{
+	struct range_it_s *it = (struct range_it_s *)data->data;
+	ssize_t count;
+
+	if (it->v > it->last)
+		return EXCIT_STOPIT;
+	count = 1 + it->last - it->v;
+	if (count > max)
+		count = max;
+	if (vals) {
+		ssize_t v = it->v;
+
+		for (ssize_t i = 0; i < count; i++)
+			vals[i] = v + i;
+	}
+	it->v += count;
+	*produced = count;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	*size = it->first > it->last ? 0 : 1 + it->last - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	if (n < 0 || n > it->last - it->first)
+		return -EXCIT_EDOM;
+	if (val)
+		*val = it->first + n;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_rank(const_excit_t data, const ssize_t *val,
+			      ssize_t *n)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	if (*val < it->first || *val > it->last)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = *val - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_nth_batch(const_excit_t data, ssize_t count,
+				   const ssize_t *ranks, ssize_t *vals)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+	ssize_t first = it->first;
+	ssize_t max = it->last - it->first;
+
+	for (ssize_t i = 0; i < count; i++)
+		if (ranks[i] < 0 || ranks[i] > max)
+			return -EXCIT_EDOM;
+	if (vals)
+		for (ssize_t i = 0; i < count; i++)
+			vals[i] = first + ranks[i];
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_rank_batch(const_excit_t data, ssize_t count,
+				    const ssize_t *vals, ssize_t *ranks)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+	ssize_t first = it->first;
+	ssize_t last = it->last;
+
+	for (ssize_t i = 0; i < count; i++) {
+		if (vals[i] < first || vals[i] > last)
+			return -EXCIT_EINVAL;
+		if (ranks)
+			ranks[i] = vals[i] - first;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct range_it_s *it = (struct range_it_s *)data->data;
+
+	if (it->v > it->last)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->v - it->first;
+	return EXCIT_SUCCESS;
+}
+
+static int range_unit_it_seek(excit_t data, ssize_t rank)
+{
+	struct range_it_s *it = (struct range_it_s *)data->data;
+
+	it->v = it->first + rank;
+	return EXCIT_SUCCESS;
+}
+
 int excit_range_init(excit_t it, ssize_t first, ssize_t last, ssize_t step)
 {
 	struct range_it_s *range_it;
@@ -195,6 +427,9 @@ int excit_range_init(excit_t it, ssize_t first, ssize_t last, ssize_t step)
 	range_it->v = first;
 	range_it->last = last;
 	range_it->step = step;
+	excit_divisor_init(&range_it->step_div, step < 0 ? -step : step);
+	it->func_table = step == 1 ? &excit_range_unit_func_table :
+	    &excit_range_func_table;
 	return EXCIT_SUCCESS;
 }
 
@@ -209,6 +444,31 @@ struct excit_func_table_s excit_range_func_table = {
 	range_it_split,
 	range_it_nth,
 	range_it_rank,
-	range_it_pos
+	range_it_pos,
+	range_it_next_batch,
+	range_it_nth_batch,
+	range_it_rank_batch,
+	range_it_seek,
+	NULL,
+	NULL
 };
 
+struct excit_func_table_s excit_range_unit_func_table = {
+	range_it_alloc,
+	range_it_free,
+	range_it_copy,
+	range_unit_it_next,
+	range_unit_it_peek,
+	range_unit_it_size,
+	range_it_rewind,
+	range_it_split,
+	range_unit_it_nth,
+	range_unit_it_rank,
+	range_unit_it_pos,
+	range_unit_it_next_batch,
+	range_unit_it_nth_batch,
+	range_unit_it_rank_batch,
+	range_unit_it_seek,
+	NULL,
+	NULL
+};
@@ -11,15 +11,20 @@
 #define EXCIT_RANGE_H
 
 #include "excit.h"
+#include "divide.h"
 
 struct range_it_s {
 	ssize_t v;
 	ssize_t first;
 	ssize_t last;
 	ssize_t step;
+	/* Divides by the absolute value of step */
+	struct excit_divisor_s step_div;
 };
 
 extern struct excit_func_table_s excit_range_func_table;
+/* Ranges with a step of 1 */
+extern struct excit_func_table_s excit_range_unit_func_table;
 
 #endif //EXCIT_RANGE_H
 
@@ -16,6 +16,7 @@ static int repeat_it_alloc(excit_t data)
 
 	it->it = NULL;
 	it->n = 0;
+	excit_divisor_init(&it->n_div, 1);
 	it->counter = 0;
 	return EXCIT_SUCCESS;
 }
@@ -37,6 +38,7 @@ static int repeat_it_copy(excit_t ddst, const_excit_t dsrc)
 		return -EXCIT_EINVAL;
 	dst->it = copy;
 	dst->n = src->n;
+	dst->n_div = src->n_div;
 	dst->counter = src->counter;
 	return EXCIT_SUCCESS;
 }
@@ -89,7 +91,7 @@ static int repeat_it_nth(const_excit_t data, ssize_t n, ssize_t *val)
 		return -EXCIT_EDOM;
 	const struct repeat_it_s *it = (const struct repeat_it_s *)data->data;
 
-	return excit_nth(it->it, n / it->n, val);
+	return excit_nth(it->it, excit_divide(&it->n_div, n), val);
 }
 
 static int repeat_it_pos(const_excit_t data, ssize_t *n)
@@ -105,6 +107,16 @@ static int repeat_it_pos(const_excit_t data, ssize_t *n)
 	return EXCIT_SUCCESS;
 }
 
+static int repeat_it_seek(excit_t data, ssize_t rank)
+{
+	struct repeat_it_s *it = (struct repeat_it_s *)data->data;
+
+	ssize_t q = excit_divide(&it->n_div, rank);
+
+	it->counter = rank - q * it->n;
+	return excit_seek(it->it, q);
+}
+
 struct excit_func_table_s excit_repeat_func_table = {
 	repeat_it_alloc,
 	repeat_it_free,
@@ -116,7 +128,13 @@ struct excit_func_table_s excit_repeat_func_table = {
 	NULL,
 	repeat_it_nth,
 	NULL,
-	repeat_it_pos
+	repeat_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	repeat_it_seek,
+	NULL,
+	NULL
 };
 
 int excit_repeat_init(excit_t it, excit_t src, ssize_t n)
@@ -128,6 +146,7 @@ int excit_repeat_init(excit_t it, excit_t src, ssize_t n)
 	it->dimension = src->dimension;
 	repeat_it->it = src;
 	repeat_it->n = n;
+	excit_divisor_init(&repeat_it->n_div, n);
 	repeat_it->counter = 0;
 	return EXCIT_SUCCESS;
 }
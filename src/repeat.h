@@ -12,10 +12,12 @@
 
 #include "excit.h"
 #include "dev/excit.h"
+#include "divide.h"
 
 struct repeat_it_s {
 	excit_t it;
 	ssize_t n;
+	struct excit_divisor_s n_div;
 	ssize_t counter;
 };
 
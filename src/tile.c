@@ -0,0 +1,614 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dev/excit.h"
+#include "tile.h"
+
+#define TILE_BUFFERS 7
+/*
+ * Tile coordinates are kept on the stack by rank for boxes of small
+ * dimension, and allocated otherwise.
+ */
+#define TILE_STACK_DIM 8
+#define TILE_CACHE_PATH "/sys/devices/system/cpu/cpu0/cache"
+
+static int tile_it_alloc(excit_t data)
+{
+	struct tile_it_s *it = (struct tile_it_s *)data->data;
+
+	it->outer = NULL;
+	it->shape = NULL;
+	it->tile = NULL;
+	it->ntiles = NULL;
+	it->inner = NULL;
+	it->prefix = NULL;
+	it->first = 0;
+	it->last = 0;
+	it->begin = 0;
+	it->end = 0;
+	it->pos = 0;
+	it->cur = -1;
+	it->origin = NULL;
+	it->extent = NULL;
+	it->coords = NULL;
+	it->coords_pos = -1;
+	return EXCIT_SUCCESS;
+}
+
+static void tile_it_free(excit_t data)
+{
+	struct tile_it_s *it = (struct tile_it_s *)data->data;
+
+	excit_free(it->outer);
+	free(it->shape);
+	free(it->prefix);
+}
+
+/*
+ * Allocates shape, tile, ntiles, inner, origin, extent and coords in a single
+ * block, and the prefix sums of count tiles.
+ */
+static int tile_it_alloc_buffers(struct tile_it_s *it, ssize_t dim,
+				 ssize_t count)
+{
+	ssize_t *buff = malloc(TILE_BUFFERS * dim * sizeof(ssize_t));
+	ssize_t *prefix = malloc((count + 1) * sizeof(ssize_t));
+
+	if (!buff || !prefix) {
+		free(buff);
+		free(prefix);
+		return -EXCIT_ENOMEM;
+	}
+	free(it->shape);
+	free(it->prefix);
+	it->shape = buff;
+	it->tile = buff + dim;
+	it->ntiles = buff + 2 * dim;
+	it->inner = buff + 3 * dim;
+	it->origin = buff + 4 * dim;
+	it->extent = buff + 5 * dim;
+	it->coords = buff + 6 * dim;
+	it->prefix = prefix;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_copy(excit_t ddst, const_excit_t dsrc)
+{
+	struct tile_it_s *dst = (struct tile_it_s *)ddst->data;
+	const struct tile_it_s *src = (const struct tile_it_s *)dsrc->data;
+	ssize_t dim = dsrc->dimension;
+	ssize_t count;
+	excit_t copy = excit_dup(src->outer);
+	int err;
+
+	if (!copy)
+		return -EXCIT_EINVAL;
+	err = excit_size(copy, &count);
+	if (!err)
+		err = tile_it_alloc_buffers(dst, dim, count);
+	if (err) {
+		excit_free(copy);
+		return err;
+	}
+	memcpy(dst->shape, src->shape, TILE_BUFFERS * dim * sizeof(ssize_t));
+	memcpy(dst->prefix, src->prefix, (count + 1) * sizeof(ssize_t));
+	dst->outer = copy;
+	dst->first = src->first;
+	dst->last = src->last;
+	dst->begin = src->begin;
+	dst->end = src->end;
+	dst->pos = src->pos;
+	dst->cur = src->cur;
+	dst->coords_pos = src->coords_pos;
+	return EXCIT_SUCCESS;
+}
+
+/* Extent along dimension d of the tile starting at origin */
+static inline ssize_t tile_it_extent(const struct tile_it_s *it, ssize_t d,
+				     ssize_t origin)
+{
+	return it->shape[d] - origin < it->tile[d] ?
+	    it->shape[d] - origin : it->tile[d];
+}
+
+/*
+ * Gets the origin of the tile of rank r, and its extent if extent is not
+ * NULL. Tile coordinates are scaled in place.
+ */
+static int tile_it_tile(const struct tile_it_s *it, ssize_t dim, ssize_t r,
+			ssize_t *origin, ssize_t *extent)
+{
+	int err = excit_nth(it->outer, r, origin);
+
+	if (err)
+		return err;
+	if (it->outer->dimension == 1) {
+		ssize_t lin = origin[0];
+
+		for (ssize_t i = dim - 1; i >= 0; i--) {
+			origin[i] = lin % it->ntiles[i];
+			lin /= it->ntiles[i];
+		}
+	}
+	for (ssize_t i = 0; i < dim; i++) {
+		if (origin[i] < 0 || origin[i] >= it->ntiles[i])
+			return -EXCIT_EINVAL;
+		origin[i] *= it->tile[i];
+		if (extent)
+			extent[i] = tile_it_extent(it, i, origin[i]);
+	}
+	return EXCIT_SUCCESS;
+}
+
+/* Finds the rank of the tile holding the element at position pos */
+static ssize_t tile_it_locate(const struct tile_it_s *it, ssize_t pos)
+{
+	ssize_t lo = it->first, hi = it->last - 1;
+
+	while (lo < hi) {
+		ssize_t mid = lo + (hi - lo + 1) / 2;
+
+		if (it->prefix[mid] <= pos)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+static inline void tile_it_decode(const struct tile_it_s *it, ssize_t dim,
+				  const ssize_t *extent, ssize_t off,
+				  ssize_t *coords)
+{
+	for (ssize_t k = dim - 1; k >= 0; k--) {
+		ssize_t d = it->inner[k];
+
+		coords[d] = off % extent[d];
+		off /= extent[d];
+	}
+}
+
+/* Uninitialized tile iterators are empty */
+static int tile_it_size(const_excit_t data, ssize_t *size)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+
+	*size = it->end - it->begin;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_rewind(excit_t data)
+{
+	struct tile_it_s *it = (struct tile_it_s *)data->data;
+
+	it->pos = it->begin;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_seek(excit_t data, ssize_t rank)
+{
+	struct tile_it_s *it = (struct tile_it_s *)data->data;
+
+	it->pos = it->begin + rank;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_pos(const_excit_t data, ssize_t *n)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+
+	if (it->pos >= it->end)
+		return EXCIT_STOPIT;
+	if (n)
+		*n = it->pos - it->begin;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_nth(const_excit_t data, ssize_t n, ssize_t *indexes)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t size, pos, r, off;
+	int err;
+
+	tile_it_size(data, &size);
+	if (n < 0 || n >= size)
+		return -EXCIT_EDOM;
+	if (!indexes)
+		return EXCIT_SUCCESS;
+	pos = it->begin + n;
+	r = tile_it_locate(it, pos);
+	err = tile_it_tile(it, dim, r, indexes, NULL);
+	if (err)
+		return err;
+	/* intra-tile coordinates are added to the origin */
+	off = pos - it->prefix[r];
+	for (ssize_t k = dim - 1; k >= 0; k--) {
+		ssize_t d = it->inner[k];
+		ssize_t extent = tile_it_extent(it, d, indexes[d]);
+
+		indexes[d] += off % extent;
+		off /= extent;
+	}
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_peek(const_excit_t data, ssize_t *indexes)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+
+	if (it->pos >= it->end)
+		return EXCIT_STOPIT;
+	return tile_it_nth(data, it->pos - it->begin, indexes);
+}
+
+/*
+ * Successive elements of a tile are produced by incrementing their intra-tile
+ * coordinates, the next tile is only fetched from the outer iterator when
+ * leaving the current one.
+ */
+static int tile_it_next(excit_t data, ssize_t *indexes)
+{
+	struct tile_it_s *it = (struct tile_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t pos = it->pos;
+
+	if (pos >= it->end)
+		return EXCIT_STOPIT;
+	if (!indexes) {
+		it->pos++;
+		return EXCIT_SUCCESS;
+	}
+	if (it->cur < 0 || pos < it->prefix[it->cur]
+	    || pos >= it->prefix[it->cur + 1]) {
+		ssize_t r = tile_it_locate(it, pos);
+		int err = tile_it_tile(it, dim, r, it->origin, it->extent);
+
+		if (err)
+			return err;
+		it->cur = r;
+		it->coords_pos = -1;
+	}
+	if (pos > it->prefix[it->cur] && it->coords_pos == pos - 1) {
+		for (ssize_t k = dim - 1; k >= 0; k--) {
+			ssize_t d = it->inner[k];
+
+			if (++it->coords[d] < it->extent[d])
+				break;
+			it->coords[d] = 0;
+		}
+	} else
+		tile_it_decode(it, dim, it->extent, pos - it->prefix[it->cur],
+			       it->coords);
+	for (ssize_t i = 0; i < dim; i++)
+		indexes[i] = it->origin[i] + it->coords[i];
+	it->coords_pos = pos;
+	it->pos++;
+	return EXCIT_SUCCESS;
+}
+
+static int tile_it_rank(const_excit_t data, const ssize_t *indexes,
+			ssize_t *n)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+	ssize_t dim = data->dimension;
+	ssize_t stack[TILE_STACK_DIM];
+	ssize_t *tc;
+	ssize_t r, off = 0, lin = 0;
+	int err = -EXCIT_EINVAL;
+
+	if (!it->prefix)
+		return -EXCIT_EINVAL;
+	tc = dim <= TILE_STACK_DIM ? stack : malloc(dim * sizeof(ssize_t));
+	if (!tc)
+		return -EXCIT_ENOMEM;
+	for (ssize_t i = 0; i < dim; i++) {
+		if (indexes[i] < 0 || indexes[i] >= it->shape[i])
+			goto exit;
+		tc[i] = indexes[i] / it->tile[i];
+		lin = lin * it->ntiles[i] + tc[i];
+	}
+	err = excit_rank(it->outer, it->outer->dimension == 1 ? &lin : tc, &r);
+exit:
+	if (tc != stack)
+		free(tc);
+	if (err)
+		return err;
+	for (ssize_t k = 0; k < dim; k++) {
+		ssize_t d = it->inner[k];
+		ssize_t rem = indexes[d] % it->tile[d];
+
+		off = off * tile_it_extent(it, d, indexes[d] - rem) + rem;
+	}
+	off += it->prefix[r];
+	if (off < it->begin || off >= it->end)
+		return -EXCIT_EINVAL;
+	if (n)
+		*n = off - it->begin;
+	return EXCIT_SUCCESS;
+}
+
+/*
+ * Parts own whole tiles when there are enough of them, and contiguous windows
+ * of elements otherwise.
+ */
+static int tile_it_split(const_excit_t data, ssize_t n, excit_t *results)
+{
+	const struct tile_it_s *it = (const struct tile_it_s *)data->data;
+	ssize_t count = it->last - it->first;
+	ssize_t size = it->end - it->begin;
+	int whole;
+
+	if (size < n)
+		return -EXCIT_EDOM;
+	if (!results)
+		return EXCIT_SUCCESS;
+	whole = count >= n && it->begin == it->prefix[it->first]
+	    && it->end == it->prefix[it->last];
+	for (ssize_t i = 0; i < n; i++) {
+		results[i] = excit_dup(data);
+		if (!results[i]) {
+			for (ssize_t j = 0; j < i; j++)
+				excit_free(results[j]);
+			return -EXCIT_ENOMEM;
+		}
+		struct tile_it_s *res_it = (struct tile_it_s *)results[i]->data;
+
+		if (whole) {
+			res_it->first = it->first +
+			    excit_split_offset(count, n, i);
+			res_it->last = it->first +
+			    excit_split_offset(count, n, i + 1);
+			res_it->begin = it->prefix[res_it->first];
+			res_it->end = it->prefix[res_it->last];
+		} else {
+			res_it->begin = it->begin +
+			    excit_split_offset(size, n, i);
+			res_it->end = it->begin +
+			    excit_split_offset(size, n, i + 1);
+			res_it->first = tile_it_locate(it, res_it->begin);
+			res_it->last = tile_it_locate(it, res_it->end - 1) + 1;
+		}
+		res_it->pos = res_it->begin;
+		res_it->cur = -1;
+	}
+	return EXCIT_SUCCESS;
+}
+
+struct excit_func_table_s excit_tile_func_table = {
+	tile_it_alloc,
+	tile_it_free,
+	tile_it_copy,
+	tile_it_next,
+	tile_it_peek,
+	tile_it_size,
+	tile_it_rewind,
+	tile_it_split,
+	tile_it_nth,
+	tile_it_rank,
+	tile_it_pos,
+	NULL,
+	NULL,
+	NULL,
+	tile_it_seek,
+	NULL,
+	NULL
+};
+
+int excit_tile_init(excit_t it, ssize_t dim, const ssize_t *shape,
+		    const ssize_t *tile_sizes, excit_t outer,
+		    const ssize_t *inner_order)
+{
+	struct tile_it_s *tile_it;
+	ssize_t count = 1, size;
+	int err;
+
+	if (!it || it->type != EXCIT_TILE || dim <= 0 || !shape
+	    || !tile_sizes)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; i < dim; i++) {
+		if (shape[i] <= 0 || tile_sizes[i] <= 0)
+			return -EXCIT_EINVAL;
+		count *= (shape[i] + tile_sizes[i] - 1) / tile_sizes[i];
+	}
+	/* inner_order must be a permutation */
+	for (ssize_t i = 0; inner_order && i < dim; i++) {
+		if (inner_order[i] < 0 || inner_order[i] >= dim)
+			return -EXCIT_EINVAL;
+		for (ssize_t j = 0; j < i; j++)
+			if (inner_order[j] == inner_order[i])
+				return -EXCIT_EINVAL;
+	}
+	if (outer) {
+		err = excit_size(outer, &size);
+		if (err)
+			return err;
+		if (size != count
+		    || (outer->dimension != 1 && outer->dimension != dim))
+			return -EXCIT_EINVAL;
+	}
+	tile_it = (struct tile_it_s *)it->data;
+	err = tile_it_alloc_buffers(tile_it, dim, count);
+	if (err)
+		return err;
+	if (!outer) {
+		outer = excit_alloc(EXCIT_RANGE);
+		if (!outer)
+			return -EXCIT_ENOMEM;
+		err = excit_range_init(outer, 0, count - 1, 1);
+		if (err) {
+			excit_free(outer);
+			return err;
+		}
+	}
+	excit_free(tile_it->outer);
+	tile_it->outer = outer;
+	for (ssize_t i = 0; i < dim; i++) {
+		tile_it->shape[i] = shape[i];
+		tile_it->tile[i] = tile_sizes[i];
+		tile_it->ntiles[i] = (shape[i] + tile_sizes[i] - 1) /
+		    tile_sizes[i];
+		tile_it->inner[i] = inner_order ? inner_order[i] : i;
+	}
+	tile_it->prefix[0] = 0;
+	for (ssize_t r = 0; r < count; r++) {
+		ssize_t volume = 1;
+
+		err = tile_it_tile(tile_it, dim, r, tile_it->origin,
+				   tile_it->extent);
+		if (err)
+			return err;
+		for (ssize_t i = 0; i < dim; i++)
+			volume *= tile_it->extent[i];
+		tile_it->prefix[r + 1] = tile_it->prefix[r] + volume;
+	}
+	it->dimension = dim;
+	tile_it->first = 0;
+	tile_it->last = count;
+	tile_it->begin = 0;
+	tile_it->end = tile_it->prefix[count];
+	tile_it->pos = 0;
+	tile_it->cur = -1;
+	tile_it->coords_pos = -1;
+	return EXCIT_SUCCESS;
+}
+
+/* Reads the first line of a cache attribute file from sysfs */
+static int tile_cache_attr(int index, const char *name, char *buf, int len)
+{
+	char path[128];
+	FILE *f;
+	char *res;
+
+	snprintf(path, sizeof(path), TILE_CACHE_PATH "/index%d/%s", index,
+		 name);
+	f = fopen(path, "r");
+	if (!f)
+		return -EXCIT_ENOTSUP;
+	res = fgets(buf, len, f);
+	fclose(f);
+	if (!res)
+		return -EXCIT_ENOTSUP;
+	buf[strcspn(buf, "\n")] = '\0';
+	return EXCIT_SUCCESS;
+}
+
+int excit_cache_info(int level, size_t *size, size_t *line_size)
+{
+	char buf[64];
+	char *end;
+
+	if (level <= 0 || !size || !line_size)
+		return -EXCIT_EINVAL;
+	for (int i = 0; tile_cache_attr(i, "level", buf, sizeof(buf)) == 0;
+	     i++) {
+		if (atoi(buf) != level)
+			continue;
+		if (tile_cache_attr(i, "type", buf, sizeof(buf))
+		    || !strcmp(buf, "Instruction"))
+			continue;
+		if (tile_cache_attr(i, "size", buf, sizeof(buf)))
+			return -EXCIT_ENOTSUP;
+		*size = strtoul(buf, &end, 10);
+		if (*end == 'K')
+			*size <<= 10;
+		else if (*end == 'M')
+			*size <<= 20;
+		else if (*end == 'G')
+			*size <<= 30;
+		if (tile_cache_attr(i, "coherency_line_size", buf, sizeof(buf)))
+			return -EXCIT_ENOTSUP;
+		*line_size = strtoul(buf, NULL, 10);
+		if (*size == 0 || *line_size == 0)
+			return -EXCIT_ENOTSUP;
+		return EXCIT_SUCCESS;
+	}
+	return -EXCIT_ENOTSUP;
+}
+
+//largest x such that x^k <= v
+static ssize_t tile_iroot(ssize_t v, ssize_t k)
+{
+	ssize_t lo = 1, hi = v;
+
+	while (lo < hi) {
+		ssize_t mid = lo + (hi - lo + 1) / 2, p = 1, i;
+
+		for (i = 0; i < k && p <= v / mid; i++)
+			p *= mid;
+		if (i == k)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+/*
+ * Tiles use half of the cache, the rest being left to other data. Extents are
+ * chosen from the innermost dimension, as close to cubic as the box allows,
+ * and the volume left by extents clamped to the box goes to the outer
+ * dimensions.
+ */
+int excit_tile_sizes(ssize_t dim, const ssize_t *shape, size_t elem_size,
+		     size_t cache_size, size_t line_size, ssize_t *tile_sizes)
+{
+	ssize_t volume, line;
+
+	if (dim <= 0 || !shape || !tile_sizes || elem_size == 0
+	    || cache_size == 0)
+		return -EXCIT_EINVAL;
+	for (ssize_t i = 0; i < dim; i++)
+		if (shape[i] <= 0)
+			return -EXCIT_EINVAL;
+	volume = cache_size / 2 / elem_size;
+	if (volume < 1)
+		volume = 1;
+	line = line_size / elem_size;
+	if (line < 1)
+		line = 1;
+	for (ssize_t i = dim - 1; i >= 0; i--) {
+		ssize_t extent = tile_iroot(volume, i + 1);
+
+		/* whole cache lines along the innermost dimension */
+		if (i == dim - 1 && extent > line)
+			extent -= extent % line;
+		if (extent > shape[i])
+			extent = shape[i];
+		tile_sizes[i] = extent;
+		volume /= extent;
+	}
+	return EXCIT_SUCCESS;
+}
+
+int excit_tile_auto(excit_t it, ssize_t dim, const ssize_t *shape,
+		    size_t elem_size, int level)
+{
+	size_t cache_size, line_size;
+	ssize_t *tile_sizes;
+	int err;
+
+	if (!it || it->type != EXCIT_TILE || dim <= 0)
+		return -EXCIT_EINVAL;
+	err = excit_cache_info(level, &cache_size, &line_size);
+	if (err)
+		return err;
+	tile_sizes = malloc(dim * sizeof(ssize_t));
+	if (!tile_sizes)
+		return -EXCIT_ENOMEM;
+	err = excit_tile_sizes(dim, shape, elem_size, cache_size, line_size,
+			       tile_sizes);
+	if (!err)
+		err = excit_tile_init(it, dim, shape, tile_sizes, NULL, NULL);
+	free(tile_sizes);
+	return err;
+}
@@ -0,0 +1,47 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#ifndef EXCIT_TILE_H
+#define EXCIT_TILE_H
+
+#include "excit.h"
+
+struct tile_it_s {
+	/* Order of the tiles: tile coordinates or row-major tile indexes */
+	excit_t outer;
+	ssize_t *shape;
+	ssize_t *tile;
+	/* Number of tiles along each dimension */
+	ssize_t *ntiles;
+	/* Dimensions from the outermost to the innermost intra-tile loop */
+	ssize_t *inner;
+	/* prefix[r] is the number of elements in the tiles of rank below r */
+	ssize_t *prefix;
+	/* Ranks of the tiles walked: [first, last) */
+	ssize_t first;
+	ssize_t last;
+	/*
+	 * Positions of the elements walked: [begin, end), whole tiles unless
+	 * the iterator was split in more parts than it has tiles.
+	 */
+	ssize_t begin;
+	ssize_t end;
+	/* Number of elements before the next one, over all tiles */
+	ssize_t pos;
+	/* Tile of rank cur, and position of the last element returned in it */
+	ssize_t cur;
+	ssize_t *origin;
+	ssize_t *extent;
+	ssize_t *coords;
+	ssize_t coords_pos;
+};
+
+extern struct excit_func_table_s excit_tile_func_table;
+
+#endif //EXCIT_TILE_H
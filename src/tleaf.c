@@ -12,6 +12,8 @@
 #include "dev/excit.h"
 #include "tleaf.h"
 
+#define TLEAF_STACK_DEPTH 16
+
 static int tleaf_init_with_it(excit_t it,
 			      ssize_t depth,
 			      const ssize_t *arities,
@@ -28,6 +30,7 @@ static int tleaf_it_alloc(excit_t it)
 	data_it->depth = 0;
 	data_it->arities = NULL;
 	data_it->buf = NULL;
+	data_it->value = 0;
 	data_it->order = NULL;
 	data_it->levels = NULL;
 	data_it->order_inverse = NULL;
@@ -49,7 +52,7 @@ static void tleaf_it_free(excit_t it)
 
 static int tleaf_it_size(const_excit_t it, ssize_t *size)
 {
-	struct tleaf_it_s *data_it = it->data;
+	const struct tleaf_it_s *data_it = it->data;
 	int err = excit_size(data_it->levels, size);
 
 	if (err != EXCIT_SUCCESS)
@@ -113,57 +116,115 @@ error:
 
 static int tleaf_it_pos(const_excit_t it, ssize_t *value)
 {
-	struct tleaf_it_s *data_it = it->data;
+	const struct tleaf_it_s *data_it = it->data;
 
 	return excit_pos(data_it->levels, value);
 }
 
-static ssize_t tleaf_it_value(struct tleaf_it_s *it)
+static ssize_t tleaf_it_value(const struct tleaf_it_s *it, const ssize_t *buf)
 {
 	ssize_t i, acc = 1, val = 0;
 
 	for (i = 0; i < it->depth; i++) {
 		/* levels are stacked following order, then decode result backward order_inverse */
-		val += acc * it->buf[it->order_inverse[it->depth - i - 1]];
+		val += acc * buf[it->order_inverse[it->depth - i - 1]];
 		acc *= it->arities[it->depth - i - 1];
 	}
 	return val;
 }
 
+/*
+ * Functions that do not move the iterator decode levels into their own
+ * buffer, so that they can be called concurrently. The buffer is on the stack
+ * for trees of depth up to TLEAF_STACK_DEPTH.
+ */
+static ssize_t *tleaf_it_scratch(const struct tleaf_it_s *it, ssize_t *stack)
+{
+	if (it->depth <= TLEAF_STACK_DEPTH)
+		return stack;
+	return malloc(it->depth * sizeof(ssize_t));
+}
+
+static void tleaf_it_scratch_free(ssize_t *buf, const ssize_t *stack)
+{
+	if (buf != stack)
+		free(buf);
+}
+
 static int tleaf_it_nth(const_excit_t it, ssize_t n, ssize_t *indexes)
+{
+	const struct tleaf_it_s *data_it = it->data;
+	ssize_t stack[TLEAF_STACK_DEPTH];
+	ssize_t *buf = tleaf_it_scratch(data_it, stack);
+	int err;
+
+	if (buf == NULL)
+		return -EXCIT_ENOMEM;
+	err = excit_nth(data_it->levels, n, buf);
+	if (err == EXCIT_SUCCESS && indexes != NULL)
+		*indexes = tleaf_it_value(data_it, buf);
+	tleaf_it_scratch_free(buf, stack);
+	return err;
+}
+
+static int tleaf_it_peek(const_excit_t it, ssize_t *value)
+{
+	const struct tleaf_it_s *data_it = it->data;
+	ssize_t stack[TLEAF_STACK_DEPTH];
+	ssize_t *buf = tleaf_it_scratch(data_it, stack);
+	int err;
+
+	if (buf == NULL)
+		return -EXCIT_ENOMEM;
+	err = excit_peek(data_it->levels, buf);
+	if (err == EXCIT_SUCCESS && value != NULL)
+		*value = tleaf_it_value(data_it, buf);
+	tleaf_it_scratch_free(buf, stack);
+	return err;
+}
+
+static int tleaf_it_next(excit_t it, ssize_t *indexes)
 {
 	struct tleaf_it_s *data_it = it->data;
-	int err = excit_nth(data_it->levels, n, data_it->buf);
+	int err = excit_next(data_it->levels, data_it->buf);
 
 	if (err != EXCIT_SUCCESS)
 		return err;
+
 	if (indexes != NULL)
-		*indexes = tleaf_it_value(data_it);
+		*indexes = tleaf_it_value(data_it, data_it->buf);
 	return EXCIT_SUCCESS;
 }
 
-static int tleaf_it_peek(const_excit_t it, ssize_t *value)
+static int tleaf_it_next_ref(excit_t it, const ssize_t **tuple)
 {
 	struct tleaf_it_s *data_it = it->data;
-	int err = excit_peek(data_it->levels, data_it->buf);
+	int err = excit_next(data_it->levels, data_it->buf);
 
 	if (err != EXCIT_SUCCESS)
 		return err;
-	if (value != NULL)
-		*value = tleaf_it_value(data_it);
+	data_it->value = tleaf_it_value(data_it, data_it->buf);
+	*tuple = &data_it->value;
 	return EXCIT_SUCCESS;
 }
 
-static int tleaf_it_next(excit_t it, ssize_t *indexes)
+static int tleaf_it_next_batch(excit_t it, ssize_t max, ssize_t *indexes,
+			       ssize_t *produced)
 {
 	struct tleaf_it_s *data_it = it->data;
-	int err = excit_next(data_it->levels, data_it->buf);
+	ssize_t count;
+	int err = EXCIT_SUCCESS;
 
-	if (err != EXCIT_SUCCESS)
+	for (count = 0; count < max; count++) {
+		err = excit_next(data_it->levels, data_it->buf);
+		if (err)
+			break;
+		if (indexes != NULL)
+			indexes[count] = tleaf_it_value(data_it, data_it->buf);
+	}
+	if (count == 0 || err < 0)
 		return err;
-
-	if (indexes != NULL)
-		*indexes = tleaf_it_value(data_it);
+	*produced = count;
 	return EXCIT_SUCCESS;
 }
 
@@ -179,24 +240,38 @@ static int tleaf_it_rank(const_excit_t it, const ssize_t *indexes, ssize_t *n)
 	if (indexes == NULL || *indexes < 0 || *indexes >= size)
 		return -EXCIT_EINVAL;
 
-	struct tleaf_it_s *data_it = it->data;
+	const struct tleaf_it_s *data_it = it->data;
+	ssize_t stack[TLEAF_STACK_DEPTH];
+	ssize_t *buf = tleaf_it_scratch(data_it, stack);
 
-	err = excit_nth(data_it->levels_inverse, *indexes, data_it->buf);
-	if (err != EXCIT_SUCCESS)
+	if (buf == NULL)
+		return -EXCIT_ENOMEM;
+	err = excit_nth(data_it->levels_inverse, *indexes, buf);
+	if (err != EXCIT_SUCCESS) {
+		tleaf_it_scratch_free(buf, stack);
 		return err;
+	}
 
 	ssize_t i, acc = 1, val = 0;
 
 	for (i = data_it->depth - 1; i >= 0; i--) {
-		val += acc * data_it->buf[data_it->order[i]];
+		val += acc * buf[data_it->order[i]];
 		acc *= data_it->arities[i];
 	}
+	tleaf_it_scratch_free(buf, stack);
 
 	if (n != NULL)
 		*n = val;
 	return EXCIT_SUCCESS;
 }
 
+static int tleaf_it_seek(excit_t it, ssize_t rank)
+{
+	struct tleaf_it_s *data_it = it->data;
+
+	return excit_seek(data_it->levels, rank);
+}
+
 static int tleaf_it_make_levels(struct tleaf_it_s *tleaf, excit_t *indexes,
 			 ssize_t *order, excit_t *levels)
 {
@@ -470,5 +545,11 @@ struct excit_func_table_s excit_tleaf_func_table = {
 	NULL,
 	tleaf_it_nth,
 	tleaf_it_rank,
-	tleaf_it_pos
+	tleaf_it_pos,
+	tleaf_it_next_batch,
+	NULL,
+	NULL,
+	tleaf_it_seek,
+	tleaf_it_next_ref,
+	NULL
 };
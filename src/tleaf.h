@@ -16,6 +16,8 @@ struct tleaf_it_s {
 	ssize_t depth;
 	ssize_t *arities;
 	ssize_t *buf;
+	/* Last value returned through excit_next_ref() */
+	ssize_t value;
 	ssize_t *order;
 	excit_t levels;
 	ssize_t *order_inverse;
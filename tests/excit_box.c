@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_box(int dim, const ssize_t *lower, const ssize_t *upper,
+			const ssize_t *step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_BOX);
+	assert(excit_box_init(it, dim, lower, upper, step) == ES);
+	return it;
+}
+
+/* The product of ranges a box is expected to iterate like */
+excit_t create_test_box_product(int dim, const ssize_t *lower,
+				const ssize_t *upper, const ssize_t *step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	for (int i = 0; i < dim; i++) {
+		excit_t range = excit_alloc_test(EXCIT_RANGE);
+
+		assert(excit_range_init(range, lower[i], upper[i],
+					step ? step[i] : 1) == ES);
+		assert(excit_product_add(it, range) == ES);
+	}
+	return it;
+}
+
+void test_alloc_init_box(int dim, const ssize_t *lower, const ssize_t *upper,
+			 const ssize_t *step)
+{
+	excit_t it;
+	ssize_t d, size, expected_size;
+	ssize_t zero[dim];
+
+	it = excit_alloc_test(EXCIT_BOX);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == 0);
+
+	for (int i = 0; i < dim; i++)
+		zero[i] = 0;
+	assert(excit_box_init(it, 0, lower, upper, step) == -EXCIT_EINVAL);
+	assert(excit_box_init(it, dim, NULL, upper, step) == -EXCIT_EINVAL);
+	assert(excit_box_init(it, dim, lower, upper, zero) == -EXCIT_EINVAL);
+	assert(excit_box_init(it, dim, lower, upper, step) == ES);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == dim);
+	assert(excit_size(it, &size) == ES);
+	excit_t prod = create_test_box_product(dim, lower, upper, step);
+
+	assert(excit_size(prod, &expected_size) == ES);
+	assert(size == expected_size);
+
+	excit_free(prod);
+	excit_free(it);
+}
+
+/*
+ * Checks that the box returns the elements of the equivalent product of
+ * ranges, in the same order.
+ */
+void test_next_box(int dim, const ssize_t *lower, const ssize_t *upper,
+		   const ssize_t *step)
+{
+	excit_t it = create_test_box(dim, lower, upper, step);
+	excit_t prod = create_test_box_product(dim, lower, upper, step);
+	ssize_t indexes1[dim], indexes2[dim];
+	int err;
+
+	while ((err = excit_next(prod, indexes2)) == ES) {
+		assert(excit_next(it, indexes1) == ES);
+		for (int i = 0; i < dim; i++)
+			assert(indexes1[i] == indexes2[i]);
+	}
+	assert(err == EXCIT_STOPIT);
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+
+	excit_free(prod);
+	excit_free(it);
+}
+
+/*
+ * Checks that parts of a split follow each other, whether they are sub-boxes
+ * or slices.
+ */
+void test_split_box(int dim, const ssize_t *lower, const ssize_t *upper,
+		    const ssize_t *step)
+{
+	excit_t it = create_test_box(dim, lower, upper, step);
+	excit_t parts[3], subparts[2];
+	ssize_t indexes1[dim], indexes2[dim], size, total = 0;
+
+	assert(excit_size(it, &size) == ES);
+	assert(excit_split(it, 3, parts) == ES);
+	for (int i = 0; i < 3; i++) {
+		ssize_t part_size;
+
+		assert(excit_size(parts[i], &part_size) == ES);
+		total += part_size;
+		if (part_size >= 2) {
+			assert(excit_split(parts[i], 2, subparts) == ES);
+			for (int j = 0; j < 2; j++) {
+				while (excit_next(subparts[j], indexes2) ==
+				       ES) {
+					assert(excit_next(it, indexes1) == ES);
+					for (int k = 0; k < dim; k++)
+						assert(indexes1[k] ==
+						       indexes2[k]);
+				}
+				excit_free(subparts[j]);
+			}
+		} else {
+			while (excit_next(parts[i], indexes2) == ES) {
+				assert(excit_next(it, indexes1) == ES);
+				for (int k = 0; k < dim; k++)
+					assert(indexes1[k] == indexes2[k]);
+			}
+		}
+		excit_free(parts[i]);
+	}
+	assert(total == size);
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+	assert(excit_split(it, size + 1, NULL) == -EXCIT_EDOM);
+
+	excit_free(it);
+}
+
+/* Parts of boxes with close to SSIZE_MAX elements start where expected */
+void test_split_large_box(void)
+{
+	ssize_t lower[2] = { 0, -1 };
+	ssize_t upper[2] = { (ssize_t)1 << 31, ((ssize_t)1 << 31) - 2 };
+	excit_t it = create_test_box(2, lower, upper, NULL);
+	excit_t parts[7];
+	ssize_t indexes1[2], indexes2[2], size, part_size, first = 0;
+
+	assert(excit_size(it, &size) == ES);
+	assert(excit_split(it, 7, parts) == ES);
+	for (int i = 0; i < 7; i++) {
+		assert(excit_size(parts[i], &part_size) == ES);
+		assert(part_size == size / 7 || part_size == size / 7 + 1);
+		assert(excit_nth(parts[i], 0, indexes2) == ES);
+		assert(excit_nth(it, first, indexes1) == ES);
+		assert(indexes1[0] == indexes2[0] && indexes1[1] == indexes2[1]);
+		first += part_size;
+		assert(excit_nth(parts[i], part_size - 1, indexes2) == ES);
+		assert(excit_nth(it, first - 1, indexes1) == ES);
+		assert(indexes1[0] == indexes2[0] && indexes1[1] == indexes2[1]);
+		excit_free(parts[i]);
+	}
+	assert(first == size);
+	excit_free(it);
+}
+
+void test_box_iterator(int dim, const ssize_t *lower, const ssize_t *upper,
+		       const ssize_t *step)
+{
+	test_alloc_init_box(dim, lower, upper, step);
+
+	test_next_box(dim, lower, upper, step);
+
+	test_split_box(dim, lower, upper, step);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_box(dim, lower, upper, step);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+int main(void)
+{
+	ssize_t lower1[1] = { 3 };
+	ssize_t upper1[1] = { 11 };
+	ssize_t lower2[2] = { 0, -2 };
+	ssize_t upper2[2] = { 5, 4 };
+	ssize_t lower3[3] = { 10, 0, 1 };
+	ssize_t upper3[3] = { 0, 3, 8 };
+	ssize_t step3[3] = { -3, 1, 2 };
+	ssize_t lower4[4] = { 0, 0, 0, 0 };
+	ssize_t upper4[4] = { 2, 1, 3, 0 };
+
+	test_box_iterator(1, lower1, upper1, NULL);
+	test_box_iterator(2, lower2, upper2, NULL);
+	test_box_iterator(3, lower3, upper3, step3);
+	test_box_iterator(4, lower4, upper4, NULL);
+	test_split_large_box();
+	return 0;
+}
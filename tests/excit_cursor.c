@@ -0,0 +1,217 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_product2(excit_t it1, excit_t it2)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it, it1) == ES);
+	assert(excit_product_add(it, it2) == ES);
+	return it;
+}
+
+excit_t create_test_cursor(const_excit_t space)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_CURSOR);
+	assert(excit_cursor_init(it, space) == ES);
+	return it;
+}
+
+/*
+ * Checks that a cursor returns the elements of its space in order, and that
+ * iterating cursors leaves the space untouched.
+ */
+void test_cursor(excit_t space, ssize_t skip)
+{
+	excit_t it;
+	ssize_t dim, size, cursor_size, pos, rank, cursor_rank;
+	int err;
+
+	for (ssize_t i = 0; i < skip; i++)
+		assert(excit_skip(space) == ES);
+	err = excit_pos(space, &pos);
+	it = create_test_cursor(space);
+	assert(excit_dimension(space, &dim) == ES);
+	assert(excit_size(space, &size) == ES);
+	assert(excit_size(it, &cursor_size) == ES);
+	assert(size == cursor_size);
+
+	ssize_t indexes1[dim], indexes2[dim];
+
+	/* cursors start at the first element whatever the space position */
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_next(it, indexes1) == ES);
+		assert(excit_nth(space, i, indexes2) == ES);
+		for (ssize_t j = 0; j < dim; j++)
+			assert(indexes1[j] == indexes2[j]);
+		if (excit_rank(space, indexes2, &rank) == ES) {
+			assert(excit_rank(it, indexes1, &cursor_rank) == ES);
+			assert(cursor_rank == rank);
+		}
+	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+	assert(excit_rewind(it) == ES);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t tmp = excit_dup(it);
+
+		synthetic_tests[i] (tmp);
+		excit_free(tmp);
+		i++;
+	}
+	if (err == ES) {
+		assert(excit_pos(space, &rank) == ES);
+		assert(rank == pos);
+	}
+	excit_free(it);
+	excit_free(space);
+}
+
+/* First rank of part p of n, the first parts getting the remainder */
+static ssize_t part_first(ssize_t size, ssize_t n, ssize_t p)
+{
+	return size / n * p + (p < size % n ? p : size % n);
+}
+
+/* Cursors over disjoint parts of a space advance independently */
+void test_cursor_interleaved(excit_t space)
+{
+	excit_t it, parts[4];
+	ssize_t dim, size, pos[4] = { 0 };
+	int done;
+
+	assert(excit_dimension(space, &dim) == ES);
+	assert(excit_size(space, &size) == ES);
+	it = create_test_cursor(space);
+	assert(excit_split(it, 4, parts) == ES);
+	excit_free(it);
+
+	ssize_t indexes1[dim], indexes2[dim];
+
+	do {
+		done = 1;
+		for (int p = 0; p < 4; p++) {
+			ssize_t first;
+
+			if (excit_next(parts[p], indexes1) != ES)
+				continue;
+			done = 0;
+			first = part_first(size, 4, p);
+			assert(excit_nth(space, first + pos[p]++, indexes2) ==
+			       ES);
+			for (ssize_t j = 0; j < dim; j++)
+				assert(indexes1[j] == indexes2[j]);
+		}
+	} while (!done);
+	for (int p = 0; p < 4; p++) {
+		assert(pos[p] == part_first(size, 4, p + 1) -
+		       part_first(size, 4, p));
+		excit_free(parts[p]);
+	}
+	excit_free(space);
+}
+
+/* Parts of cursors with close to SSIZE_MAX elements start where expected */
+void test_split_large_cursor(void)
+{
+	excit_t space, it, parts[3];
+	ssize_t indexes1[2], indexes2[2], size, part_size, first = 0;
+
+	space = create_test_product2(create_test_range(0, (ssize_t)1 << 31, 1),
+				     create_test_range(0,
+						       ((ssize_t)1 << 31) - 1,
+						       1));
+	it = create_test_cursor(space);
+	assert(excit_size(it, &size) == ES);
+	assert(excit_split(it, 3, parts) == ES);
+	for (int p = 0; p < 3; p++) {
+		assert(excit_size(parts[p], &part_size) == ES);
+		assert(part_size == size / 3 || part_size == size / 3 + 1);
+		assert(excit_next(parts[p], indexes1) == ES);
+		assert(excit_nth(space, first, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		first += part_size;
+		assert(excit_nth(parts[p], part_size - 1, indexes1) == ES);
+		assert(excit_nth(space, first - 1, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		excit_free(parts[p]);
+	}
+	assert(first == size);
+	excit_free(it);
+	excit_free(space);
+}
+
+int main(void)
+{
+	excit_t it, space;
+	ssize_t arities[2] = { 3, 4 };
+	ssize_t index[5] = { 7, -3, 4, 12, 0 };
+
+	it = excit_alloc_test(EXCIT_CURSOR);
+	assert(excit_cursor_init(it, NULL) == -EXCIT_EINVAL);
+	assert(excit_cursor_init(NULL, it) == -EXCIT_EINVAL);
+	excit_free(it);
+
+	test_cursor(create_test_product2(create_test_range(0, 3, 1),
+					 create_test_range(5, -1, -2)), 5);
+
+	space = excit_alloc_test(EXCIT_TLEAF);
+	assert(excit_tleaf_init(space, 3, arities, NULL,
+				TLEAF_POLICY_ROUND_ROBIN, NULL) == ES);
+	test_cursor(space, 2);
+
+	space = excit_alloc_test(EXCIT_INDEX);
+	assert(excit_index_init(space, 5, index) == ES);
+	test_cursor(space, 0);
+
+	space = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(space, 3) == ES);
+	test_cursor(space, 7);
+
+	/* a cursor can be the space of another cursor */
+	space = create_test_product2(create_test_range(0, 5, 1),
+				     create_test_range(0, 2, 1));
+	it = create_test_cursor(space);
+	assert(excit_skip(it) == ES);
+	test_cursor(it, 0);
+	excit_free(space);
+
+	test_cursor_interleaved(create_test_product2(create_test_range(0, 6, 1),
+						     create_test_range(0, 4,
+								       1)));
+	space = excit_alloc_test(EXCIT_TLEAF);
+	assert(excit_tleaf_init(space, 3, arities, NULL, TLEAF_POLICY_SCATTER,
+				NULL) == ES);
+	test_cursor_interleaved(space);
+
+	test_split_large_cursor();
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "divide.h"
+
+#define MAX ((ssize_t)(~(size_t)0 >> 1))
+
+static void check_divide(const struct excit_divisor_s *div, ssize_t n)
+{
+	if (n < 0)
+		return;
+	assert(excit_divide(div, n) == n / div->d);
+}
+
+/* Checks dividends around multiples of d, powers of two and MAX */
+void test_divide(ssize_t d)
+{
+	struct excit_divisor_s div;
+	ssize_t last = MAX / d;
+	size_t seed = (size_t)d;
+
+	excit_divisor_init(&div, d);
+	assert(div.d == d);
+	for (ssize_t n = 0; n < 1024; n++)
+		check_divide(&div, n);
+	for (ssize_t q = 1; q <= last; q = q < 64 ? q + 1 : q * 3 + 1) {
+		check_divide(&div, q * d - 1);
+		check_divide(&div, q * d);
+		if (q * d < MAX)
+			check_divide(&div, q * d + 1);
+		if (q > last / 3)
+			break;
+	}
+	check_divide(&div, last * d - 1);
+	check_divide(&div, last * d);
+	for (int b = 0; b < 63; b++)
+		for (ssize_t k = -1; k <= 1; k++)
+			check_divide(&div, ((ssize_t)1 << b) + k);
+	for (ssize_t k = 0; k < 16; k++)
+		check_divide(&div, MAX - k);
+	for (int i = 0; i < 4096; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		check_divide(&div, (ssize_t)(seed >> 1));
+		check_divide(&div, (ssize_t)(seed >> (1 + i % 62)));
+	}
+}
+
+int main(void)
+{
+	ssize_t small[] = { 1, 2, 3, 5, 6, 7, 9, 10, 11, 12, 13, 25, 100, 641,
+		1000, 6700417
+	};
+	struct excit_divisor_s div;
+
+	for (size_t i = 0; i < sizeof(small) / sizeof(*small); i++)
+		test_divide(small[i]);
+	for (int b = 1; b < 63; b++) {
+		test_divide((ssize_t)1 << b);
+		test_divide(((ssize_t)1 << b) - 1);
+		test_divide(((ssize_t)1 << b) + 1);
+	}
+	for (ssize_t k = 0; k < 4; k++) {
+		test_divide(MAX - k);
+		test_divide(MAX / 2 - k);
+		test_divide(MAX / 3 + k);
+	}
+
+	/* divisors that are not positive are replaced by 1 */
+	excit_divisor_init(&div, 0);
+	assert(div.d == 1);
+	assert(excit_divide(&div, 42) == 42);
+	excit_divisor_init(&div, -3);
+	assert(div.d == 1);
+	assert(excit_divide(&div, MAX) == MAX);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "excit.h"
+#include "excit_test.h"
+
+void test_alloc_init_gilbert(int dim, const ssize_t *sizes)
+{
+	excit_t it;
+	ssize_t d, size, expected_size = 1;
+
+	it = excit_alloc_test(EXCIT_GILBERT);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == 0);
+
+	assert(excit_gilbert_init(it, 1, sizes) == -EXCIT_EINVAL);
+	assert(excit_gilbert_init(it, 4, sizes) == -EXCIT_EINVAL);
+	assert(excit_gilbert_init(it, dim, NULL) == -EXCIT_EINVAL);
+	assert(excit_gilbert_init(it, dim, sizes) == ES);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == dim);
+	for (int i = 0; i < dim; i++)
+		expected_size *= sizes[i];
+	assert(excit_size(it, &size) == ES);
+	assert(size == expected_size);
+
+	excit_free(it);
+}
+
+excit_t create_test_gilbert(int dim, const ssize_t *sizes)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_GILBERT);
+	assert(excit_gilbert_init(it, dim, sizes) == ES);
+	return it;
+}
+
+/*
+ * Checks that every point of the box is visited once, and that consecutive
+ * points are neighbors when extents are even.
+ */
+void test_next_gilbert(int dim, const ssize_t *sizes, int continuous)
+{
+	excit_t it = create_test_gilbert(dim, sizes);
+	ssize_t size;
+	ssize_t indexes1[dim], indexes2[dim];
+	char *visited;
+
+	assert(excit_size(it, &size) == ES);
+	visited = calloc(size, 1);
+	for (ssize_t i = 0; i < size; i++) {
+		ssize_t cell = 0, dist = 0;
+
+		assert(excit_next(it, indexes1) == ES);
+		for (int j = 0; j < dim; j++) {
+			assert(indexes1[j] >= 0 && indexes1[j] < sizes[j]);
+			cell = cell * sizes[j] + indexes1[j];
+			if (i > 0)
+				dist += labs(indexes1[j] - indexes2[j]);
+		}
+		assert(!visited[cell]);
+		visited[cell] = 1;
+		assert(i == 0 || !continuous || dist == 1);
+		memcpy(indexes2, indexes1, sizeof(indexes1));
+	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+
+	free(visited);
+	excit_free(it);
+}
+
+void test_gilbert_iterator(int dim, const ssize_t *sizes, int continuous)
+{
+	test_alloc_init_gilbert(dim, sizes);
+
+	test_next_gilbert(dim, sizes, continuous);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_gilbert(dim, sizes);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+int main(void)
+{
+	ssize_t sizes1[2] = { 12, 7 };
+	ssize_t sizes2[2] = { 5, 9 };
+	ssize_t sizes3[2] = { 1, 6 };
+	ssize_t sizes4[3] = { 4, 6, 8 };
+	ssize_t sizes5[3] = { 5, 3, 7 };
+	ssize_t sizes6[3] = { 10, 2, 1 };
+
+	test_gilbert_iterator(2, sizes1, 1);
+	test_gilbert_iterator(2, sizes2, 0);
+	test_gilbert_iterator(2, sizes3, 1);
+	test_gilbert_iterator(3, sizes4, 1);
+	test_gilbert_iterator(3, sizes5, 0);
+	test_gilbert_iterator(3, sizes6, 0);
+	return 0;
+}
@@ -80,14 +80,20 @@ excit_t create_test_hilbert2d(int order)
 void test_next_hilbert2d(int order)
 {
 	excit_t it = create_test_hilbert2d(order);
-	ssize_t indexes1[2], indexes2[2];
+	ssize_t indexes1[2], indexes2[2], rank;
 
-	for (int i = 0; i < (1 << order) * (1 << order); i++) {
+	for (ssize_t i = 0; i < (ssize_t)1 << (2 * order); i++) {
+		d2xy((ssize_t)1 << order, i, indexes2, indexes2 + 1);
+		assert(excit_nth(it, i, indexes1) == ES);
+		assert(indexes1[0] == indexes2[0]);
+		assert(indexes1[1] == indexes2[1]);
+		assert(excit_rank(it, indexes2, &rank) == ES);
+		assert(rank == i);
 		assert(excit_next(it, indexes1) == ES);
-		d2xy(1 << order, i, indexes2, indexes2 + 1);
 		assert(indexes1[0] == indexes2[0]);
 		assert(indexes1[1] == indexes2[1]);
 	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
 	excit_free(it);
 }
 
@@ -111,6 +117,14 @@ void test_hilbert2d_iterator(int order)
 
 int main(void)
 {
+	test_hilbert2d_iterator(1);
+	test_hilbert2d_iterator(2);
 	test_hilbert2d_iterator(3);
 	test_hilbert2d_iterator(4);
+	test_hilbert2d_iterator(5);
+	test_hilbert2d_iterator(6);
+	test_hilbert2d_iterator(7);
+	/* orders spanning more than two lookup chunks */
+	test_next_hilbert2d(9);
+	test_next_hilbert2d(10);
 }
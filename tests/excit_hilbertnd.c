@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "excit.h"
+#include "excit_test.h"
+
+void test_alloc_init_hilbertnd(int dim, int order)
+{
+	excit_t it;
+	ssize_t d, size;
+
+	it = excit_alloc_test(EXCIT_HILBERTND);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == 0);
+
+	assert(excit_hilbertnd_init(it, 0, order) == -EXCIT_EINVAL);
+	assert(excit_hilbertnd_init(it, dim, 0) == -EXCIT_EINVAL);
+	assert(excit_hilbertnd_init(it, dim, 64) == -EXCIT_EDOM);
+	assert(excit_hilbertnd_init(it, dim, order) == ES);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == dim);
+	assert(excit_size(it, &size) == ES);
+	assert(size == (ssize_t)1 << (dim * order));
+
+	excit_free(it);
+}
+
+excit_t create_test_hilbertnd(int dim, int order)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_HILBERTND);
+	assert(excit_hilbertnd_init(it, dim, order) == ES);
+	return it;
+}
+
+/*
+ * Checks that every point of the cube is visited once, and that consecutive
+ * points are neighbors.
+ */
+void test_next_hilbertnd(int dim, int order)
+{
+	excit_t it = create_test_hilbertnd(dim, order);
+	ssize_t size = (ssize_t)1 << (dim * order);
+	char *visited = calloc(size, 1);
+	ssize_t indexes1[dim], indexes2[dim];
+
+	for (ssize_t i = 0; i < size; i++) {
+		ssize_t cell = 0, dist = 0;
+
+		assert(excit_next(it, indexes1) == ES);
+		for (int j = 0; j < dim; j++) {
+			assert(indexes1[j] >= 0 && indexes1[j] < 1 << order);
+			cell = (cell << order) | indexes1[j];
+			if (i > 0)
+				dist += labs(indexes1[j] - indexes2[j]);
+		}
+		assert(!visited[cell]);
+		visited[cell] = 1;
+		assert(i == 0 || dist == 1);
+		memcpy(indexes2, indexes1, sizeof(indexes1));
+	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+
+	free(visited);
+	excit_free(it);
+}
+
+void test_hilbertnd_iterator(int dim, int order)
+{
+	test_alloc_init_hilbertnd(dim, order);
+
+	test_next_hilbertnd(dim, order);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_hilbertnd(dim, order);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+int main(void)
+{
+	test_hilbertnd_iterator(1, 4);
+	test_hilbertnd_iterator(2, 3);
+	test_hilbertnd_iterator(3, 3);
+	test_hilbertnd_iterator(4, 2);
+	return 0;
+}
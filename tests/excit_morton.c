@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+/* Interleaves coordinate bits, the last coordinate first at each level */
+static ssize_t interleave(int dim, const ssize_t *bits, const ssize_t *val)
+{
+	ssize_t d = 0, pos = 0;
+
+	for (int l = 0; l < 64; l++)
+		for (int i = dim - 1; i >= 0; i--)
+			if (l < bits[i])
+				d |= ((val[i] >> l) & 1) << pos++;
+	return d;
+}
+
+void test_alloc_init_morton(int dim, const ssize_t *bits)
+{
+	excit_t it;
+	ssize_t d, size, expected_size = 1;
+	ssize_t large_bits[2] = { 40, 40 };
+
+	it = excit_alloc_test(EXCIT_MORTON);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == 0);
+
+	assert(excit_morton_init(it, 0, bits) == -EXCIT_EINVAL);
+	assert(excit_morton_init(it, dim, NULL) == -EXCIT_EINVAL);
+	assert(excit_morton_init(it, 2, large_bits) == -EXCIT_EDOM);
+	assert(excit_morton_init(it, dim, bits) == ES);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == dim);
+	for (int i = 0; i < dim; i++)
+		expected_size <<= bits[i];
+	assert(excit_size(it, &size) == ES);
+	assert(size == expected_size);
+
+	excit_free(it);
+}
+
+excit_t create_test_morton(int dim, const ssize_t *bits)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_MORTON);
+	assert(excit_morton_init(it, dim, bits) == ES);
+	return it;
+}
+
+void test_next_morton(int dim, const ssize_t *bits)
+{
+	excit_t it = create_test_morton(dim, bits);
+	ssize_t indexes[dim];
+	ssize_t d = 0;
+
+	while (excit_next(it, indexes) == ES) {
+		for (int i = 0; i < dim; i++)
+			assert(indexes[i] >= 0 && indexes[i] < 1 << bits[i]);
+		assert(interleave(dim, bits, indexes) == d);
+		d++;
+	}
+	excit_free(it);
+}
+
+void test_morton_iterator(int dim, const ssize_t *bits)
+{
+	test_alloc_init_morton(dim, bits);
+
+	test_next_morton(dim, bits);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_morton(dim, bits);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+/* Checks nth and rank on spread out ranks of curves too large to traverse */
+void test_nth_rank_morton(int dim, const ssize_t *bits)
+{
+	excit_t it = create_test_morton(dim, bits);
+	ssize_t indexes[dim];
+	ssize_t size, rank;
+
+	assert(excit_size(it, &size) == ES);
+	for (ssize_t d = size - 1; d > 0; d = d / 3 * 2) {
+		assert(excit_nth(it, d, indexes) == ES);
+		for (int i = 0; i < dim; i++)
+			assert(indexes[i] >= 0 &&
+			       indexes[i] < (ssize_t)1 << bits[i]);
+		assert(interleave(dim, bits, indexes) == d);
+		assert(excit_rank(it, indexes, &rank) == ES);
+		assert(rank == d);
+	}
+	excit_free(it);
+}
+
+void test_morton(void)
+{
+	ssize_t bits1[1] = { 5 };
+	ssize_t bits2[2] = { 3, 3 };
+	ssize_t bits3[3] = { 1, 3, 2 };
+	ssize_t bits4[4] = { 2, 0, 2, 3 };
+	ssize_t large_bits2[2] = { 31, 31 };
+	ssize_t large_bits3[3] = { 25, 12, 24 };
+
+	test_morton_iterator(1, bits1);
+	test_morton_iterator(2, bits2);
+	test_morton_iterator(3, bits3);
+	test_morton_iterator(4, bits4);
+	test_nth_rank_morton(2, large_bits2);
+	test_nth_rank_morton(3, large_bits3);
+}
+
+int main(void)
+{
+	test_morton();
+	/* the portable bit scatter and gather are used where BMI2 is not */
+	assert(setenv("EXCIT_MORTON_PORTABLE", "1", 1) == 0);
+	test_morton();
+	return 0;
+}
@@ -0,0 +1,192 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_offset(excit_t sit, const ssize_t *strides, ssize_t base)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_OFFSET);
+	assert(excit_offset_init(it, excit_dup(sit), strides, base) == ES);
+	return it;
+}
+
+void test_alloc_init_offset(excit_t sit, const ssize_t *strides, ssize_t base)
+{
+	excit_t it;
+	ssize_t dim, size, expected_size;
+
+	it = excit_alloc_test(EXCIT_OFFSET);
+	assert(excit_dimension(it, &dim) == ES);
+	assert(dim == 0);
+
+	assert(excit_offset_init(it, excit_dup(sit), strides, base) == ES);
+	assert(excit_dimension(it, &dim) == ES);
+	assert(dim == 1);
+	assert(excit_size(sit, &expected_size) == ES);
+	assert(excit_size(it, &size) == ES);
+	assert(size == expected_size);
+
+	excit_free(it);
+}
+
+void test_next_offset(excit_t sit, const ssize_t *strides, ssize_t base)
+{
+	excit_t it, new_sit;
+	ssize_t *indexes;
+	ssize_t dim, offset, expected_offset;
+
+	it = create_test_offset(sit, strides, base);
+	new_sit = excit_dup(sit);
+
+	assert(excit_dimension(sit, &dim) == ES);
+	indexes = (ssize_t *) malloc(dim * sizeof(ssize_t));
+
+	while (excit_next(new_sit, indexes) == ES) {
+		expected_offset = base;
+		for (int i = 0; i < dim; i++)
+			expected_offset += indexes[i] * strides[i];
+		assert(excit_next(it, &offset) == ES);
+		assert(offset == expected_offset);
+	}
+	assert(excit_next(it, &offset) == EXCIT_STOPIT);
+
+	free(indexes);
+	excit_free(it);
+	excit_free(new_sit);
+}
+
+/*
+ * Checks that offsets are ranked back when the layout is nested, and that
+ * rank is not supported otherwise.
+ */
+void test_rank_offset(excit_t sit, const ssize_t *strides, ssize_t base,
+		      int nested)
+{
+	excit_t it;
+	ssize_t size, offset, rank, first = 0;
+
+	it = create_test_offset(sit, strides, base);
+	assert(excit_size(it, &size) == ES);
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_nth(it, i, &offset) == ES);
+		if (nested) {
+			assert(excit_rank(it, &offset, &rank) == ES);
+			assert(rank == i);
+		} else {
+			assert(excit_rank(it, &offset, &rank) ==
+			       -EXCIT_ENOTSUP);
+		}
+		if (i == 0 || offset < first)
+			first = offset;
+	}
+	/* offsets below the layout are rejected */
+	first--;
+	if (nested)
+		assert(excit_rank(it, &first, &rank) == -EXCIT_EINVAL);
+	excit_free(it);
+}
+
+void test_offset_iterator(excit_t sit, const ssize_t *strides, ssize_t base,
+			  int nested)
+{
+	test_alloc_init_offset(sit, strides, base);
+
+	test_next_offset(sit, strides, base);
+
+	test_rank_offset(sit, strides, base, nested);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_offset(sit, strides, base);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+int main(void)
+{
+	excit_t it1, it2, it3, it4, it5, it6, it7, it8;
+	ssize_t strides1[1] = { 3 };
+	ssize_t strides3[2] = { 8, 1 };
+	ssize_t strides4[3] = { 64, 8, 1 };
+	ssize_t strides5[2] = { -5, 7 };
+	ssize_t strides6[2] = { 3, 2 };
+	ssize_t strides7[2] = { 1, 6 };
+	ssize_t strides8[9], lower8[9], upper8[9];
+
+	it1 = create_test_range(0, 7, 1);
+	test_offset_iterator(it1, strides1, 10, 1);
+	it2 = create_test_range(1, 6, 2);
+
+	it3 = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add_copy(it3, it1) == ES);
+	assert(excit_product_add_copy(it3, it2) == ES);
+	test_offset_iterator(it3, strides3, 0, 1);
+	test_offset_iterator(it3, strides5, 42, 0);
+
+	it4 = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add_copy(it4, it1) == ES);
+	assert(excit_product_add_copy(it4, it3) == ES);
+	test_offset_iterator(it4, strides4, 1024, 1);
+
+	it5 = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(it5, 3) == ES);
+	test_offset_iterator(it5, strides3, 0, 0);
+
+	/* injective but not nested: 4 is (0, 2), not (1, 0) plus 1 */
+	it6 = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it6, create_test_range(0, 1, 1)) == ES);
+	assert(excit_product_add(it6, create_test_range(0, 2, 1)) == ES);
+	test_offset_iterator(it6, strides6, 0, 0);
+
+	/* negative coordinates, column-major order */
+	it7 = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it7, create_test_range(-3, 2, 1)) == ES);
+	assert(excit_product_add(it7, create_test_range(4, -2, -3)) == ES);
+	test_offset_iterator(it7, strides7, 5, 1);
+	test_offset_iterator(it7, strides6, 5, 0);
+
+	/* sources of large dimension */
+	for (int i = 0; i < 9; i++) {
+		strides8[i] = (ssize_t)1 << (8 - i);
+		lower8[i] = -(i % 2);
+		upper8[i] = lower8[i] + 1;
+	}
+	it8 = excit_alloc_test(EXCIT_BOX);
+	assert(excit_box_init(it8, 9, lower8, upper8, NULL) == ES);
+	test_offset_iterator(it8, strides8, -3, 1);
+
+	excit_free(it1);
+	excit_free(it2);
+	excit_free(it3);
+	excit_free(it4);
+	excit_free(it5);
+	excit_free(it6);
+	excit_free(it7);
+	excit_free(it8);
+	return 0;
+}
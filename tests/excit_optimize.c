@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_product2(excit_t it1, excit_t it2)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it, it1) == ES);
+	assert(excit_product_add(it, it2) == ES);
+	return it;
+}
+
+excit_t create_test_composition(excit_t src, excit_t indexer)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_COMPOSITION);
+	assert(excit_composition_init(it, src, indexer) == ES);
+	return it;
+}
+
+excit_t create_test_repeat(excit_t src, ssize_t n)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_REPEAT);
+	assert(excit_repeat_init(it, src, n) == ES);
+	return it;
+}
+
+excit_t create_test_loop(excit_t src, ssize_t n)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_LOOP);
+	assert(excit_loop_init(it, src, n) == ES);
+	return it;
+}
+
+/*
+ * Checks that it and ref have the same elements, ranks, and remaining
+ * elements from their current position.
+ */
+void test_equivalent(excit_t it, excit_t ref)
+{
+	ssize_t dim, ref_dim, size, ref_size, rank, ref_rank;
+	int err1, err2;
+
+	assert(excit_dimension(it, &dim) == ES);
+	assert(excit_dimension(ref, &ref_dim) == ES);
+	assert(dim == ref_dim);
+	assert(excit_size(it, &size) == ES);
+	assert(excit_size(ref, &ref_size) == ES);
+	assert(size == ref_size);
+
+	ssize_t indexes1[dim], indexes2[dim];
+
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_nth(it, i, indexes1) == ES);
+		assert(excit_nth(ref, i, indexes2) == ES);
+		for (ssize_t j = 0; j < dim; j++)
+			assert(indexes1[j] == indexes2[j]);
+		/* repeat iterators have no rank, their rewrites may have one */
+		err2 = excit_rank(ref, indexes2, &ref_rank);
+		if (err2 == ES) {
+			assert(excit_rank(it, indexes1, &rank) == ES);
+			assert(rank == ref_rank);
+		}
+	}
+	do {
+		err1 = excit_next(it, indexes1);
+		err2 = excit_next(ref, indexes2);
+		assert(err1 == err2);
+		for (ssize_t j = 0; err1 == ES && j < dim; j++)
+			assert(indexes1[j] == indexes2[j]);
+	} while (err1 == ES);
+	assert(err1 == EXCIT_STOPIT);
+}
+
+/*
+ * Optimizes a copy of it after skipping some elements, and checks the result
+ * has the expected type and is equivalent.
+ */
+void test_optimize(excit_t it, ssize_t skip, enum excit_type_e expected)
+{
+	excit_t opt = excit_dup(it);
+	enum excit_type_e type;
+
+	assert(opt != NULL);
+	for (ssize_t i = 0; i < skip; i++) {
+		assert(excit_skip(it) == ES);
+		assert(excit_skip(opt) == ES);
+	}
+	assert(excit_optimize(&opt) == ES);
+	assert(excit_type(opt, &type) == ES);
+	assert(type == expected);
+	test_equivalent(opt, it);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t tmp = excit_dup(opt);
+
+		assert(excit_rewind(tmp) == ES);
+		synthetic_tests[i] (tmp);
+		excit_free(tmp);
+		i++;
+	}
+	excit_free(opt);
+	excit_free(it);
+}
+
+int main(void)
+{
+	excit_t it, inner, parts[3];
+
+	/* nested products of ranges become a box */
+	inner = create_test_product2(create_test_range(1, -1, -1),
+				     create_test_range(-5, 5, 3));
+	it = create_test_product2(create_test_range(0, 3, 1), inner);
+	test_optimize(it, 7, EXCIT_BOX);
+
+	/* a single factor is returned as is */
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it, create_test_range(2, 9, 2)) == ES);
+	test_optimize(it, 1, EXCIT_RANGE);
+
+	/* factors that are not ranges are kept, a slice stays a product */
+	inner = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(inner, 2) == ES);
+	it = create_test_product2(inner,
+				  create_test_product2(create_test_range(0, 2, 1),
+						       create_test_range(3, 4,
+									 1)));
+	assert(excit_split(it, 3, parts) == ES);
+	excit_free(it);
+	test_optimize(parts[0], 0, EXCIT_PRODUCT);
+	test_optimize(parts[1], 5, EXCIT_PRODUCT);
+	test_optimize(parts[2], 0, EXCIT_PRODUCT);
+
+	/* a range indexed by a range is a range */
+	it = create_test_composition(create_test_range(10, 40, 3),
+				     create_test_range(1, 7, 2));
+	test_optimize(it, 2, EXCIT_RANGE);
+	it = create_test_composition(create_test_range(10, -10, -1),
+				     create_test_range(15, 3, -4));
+	test_optimize(it, 0, EXCIT_RANGE);
+
+	/* indexing every rank in order is the identity */
+	inner = create_test_product2(create_test_range(0, 2, 1),
+				     create_test_range(0, 3, 1));
+	it = create_test_composition(inner, create_test_range(0, 11, 1));
+	test_optimize(it, 3, EXCIT_BOX);
+
+	/* indexes outside of the source are not folded */
+	it = create_test_composition(create_test_range(0, 9, 1),
+				     create_test_range(5, 12, 1));
+	inner = it;
+	assert(excit_optimize(&it) == ES);
+	assert(it == inner);
+	excit_free(it);
+
+	/* nested repeat and loop iterators are merged */
+	inner = create_test_repeat(create_test_range(0, 4, 1), 2);
+	it = create_test_repeat(inner, 3);
+	test_optimize(it, 4, EXCIT_REPEAT);
+	it = create_test_repeat(create_test_range(0, 4, 1), 1);
+	test_optimize(it, 4, EXCIT_RANGE);
+	inner = create_test_loop(create_test_range(0, 4, 2), 2);
+	it = create_test_loop(inner, 3);
+	test_optimize(it, 7, EXCIT_LOOP);
+	inner = create_test_repeat(create_test_range(0, 2, 1), 1);
+	it = create_test_loop(inner, 1);
+	test_optimize(it, 2, EXCIT_RANGE);
+
+	/* the position of a depleted iterator is kept */
+	it = create_test_product2(create_test_range(0, 1, 1),
+				  create_test_range(0, 2, 1));
+	test_optimize(it, 6, EXCIT_BOX);
+	return 0;
+}
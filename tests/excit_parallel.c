@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_parallel.h"
+#include "excit_test.h"
+
+#define MAX_WORKERS 64
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_product2(excit_t it1, excit_t it2)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it, it1) == ES);
+	assert(excit_product_add(it, it2) == ES);
+	return it;
+}
+
+/*
+ * A user-defined iterator over [first, end) that can only be traversed in
+ * order, or split.
+ */
+struct counter_s {
+	ssize_t first;
+	ssize_t end;
+	ssize_t cur;
+};
+
+static int counter_alloc(excit_t it)
+{
+	struct counter_s *c;
+
+	assert(excit_get_data(it, (void **)&c) == ES);
+	c->first = 0;
+	c->end = 0;
+	c->cur = 0;
+	return ES;
+}
+
+static void counter_free(excit_t it)
+{
+	(void)it;
+}
+
+static int counter_peek(const_excit_t it, ssize_t *indexes)
+{
+	struct counter_s *c;
+
+	assert(excit_get_data((excit_t)it, (void **)&c) == ES);
+	if (c->cur >= c->end)
+		return EXCIT_STOPIT;
+	if (indexes)
+		indexes[0] = c->cur;
+	return ES;
+}
+
+static int counter_next(excit_t it, ssize_t *indexes)
+{
+	struct counter_s *c;
+	int err = counter_peek(it, indexes);
+
+	if (err)
+		return err;
+	assert(excit_get_data(it, (void **)&c) == ES);
+	c->cur++;
+	return ES;
+}
+
+static int counter_size(const_excit_t it, ssize_t *size)
+{
+	struct counter_s *c;
+
+	assert(excit_get_data((excit_t)it, (void **)&c) == ES);
+	*size = c->end - c->first;
+	return ES;
+}
+
+static int counter_rewind(excit_t it)
+{
+	struct counter_s *c;
+
+	assert(excit_get_data(it, (void **)&c) == ES);
+	c->cur = c->first;
+	return ES;
+}
+
+excit_t create_test_counter(ssize_t first, ssize_t end);
+
+static int counter_split(const_excit_t it, ssize_t n, excit_t *results)
+{
+	struct counter_s *c;
+	ssize_t size;
+
+	assert(excit_get_data((excit_t)it, (void **)&c) == ES);
+	size = c->end - c->first;
+	if (size < n)
+		return -EXCIT_EDOM;
+	for (ssize_t i = 0; results && i < n; i++)
+		results[i] = create_test_counter(c->first + size * i / n,
+						 c->first + size * (i + 1) / n);
+	return ES;
+}
+
+static struct excit_func_table_s counter_func_table = {
+	counter_alloc,
+	counter_free,
+	NULL,
+	counter_next,
+	counter_peek,
+	counter_size,
+	counter_rewind,
+	counter_split,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+excit_t create_test_counter(ssize_t first, ssize_t end)
+{
+	excit_t it;
+	struct counter_s *c;
+
+	it = excit_alloc_user(&counter_func_table, sizeof(struct counter_s));
+	assert(it);
+	assert(excit_set_dimension(it, 1) == ES);
+	assert(excit_get_data(it, (void **)&c) == ES);
+	c->first = first;
+	c->end = end;
+	c->cur = first;
+	return it;
+}
+
+struct visit_s {
+	ssize_t dim;
+	ssize_t size;
+	/* Elements of the serial traversal */
+	ssize_t *expected;
+	/* Number of visits of each rank */
+	int *visits;
+	/* Number of elements visited by each worker */
+	ssize_t counts[MAX_WORKERS];
+	int nthreads;
+	/* Rank after which traversals stop, -1 to visit everything */
+	ssize_t stop_rank;
+};
+
+static int visit(const ssize_t *indexes, ssize_t rank, int worker, void *ctx)
+{
+	struct visit_s *v = (struct visit_s *)ctx;
+
+	assert(worker >= 0 && worker < v->nthreads);
+	v->counts[worker]++;
+	assert(rank >= 0 && rank < v->size);
+	for (ssize_t j = 0; j < v->dim; j++)
+		assert(indexes[j] == v->expected[rank * v->dim + j]);
+	v->visits[rank]++;
+	return rank == v->stop_rank ? 42 : 0;
+}
+
+/*
+ * Checks that every element of it is visited once, with its rank, and that
+ * the position of it is kept.
+ */
+void test_parallel_for(excit_t it, ssize_t skip, int nthreads, ssize_t grain)
+{
+	struct visit_s v;
+	ssize_t pos, total = 0;
+	int err;
+
+	for (ssize_t i = 0; i < skip; i++)
+		assert(excit_skip(it) == ES);
+	err = excit_pos(it, &pos);
+	assert(excit_dimension(it, &v.dim) == ES);
+	assert(excit_size(it, &v.size) == ES);
+	v.expected = malloc((v.size + 1) * v.dim * sizeof(ssize_t));
+	v.visits = calloc(v.size + 1, sizeof(int));
+	assert(v.expected && v.visits);
+	assert(excit_rewind(it) == ES);
+	for (ssize_t i = 0; i < v.size; i++)
+		assert(excit_next(it, v.expected + i * v.dim) == ES);
+	assert(excit_next(it, NULL) == EXCIT_STOPIT);
+	if (err == ES) {
+		assert(excit_seek(it, pos) == ES);
+	} else {
+		assert(excit_rewind(it) == ES);
+		for (ssize_t i = 0; i < skip; i++)
+			assert(excit_skip(it) == ES);
+	}
+
+	v.nthreads = nthreads;
+	v.stop_rank = -1;
+	for (int i = 0; i < MAX_WORKERS; i++)
+		v.counts[i] = 0;
+	assert(excit_parallel_for(it, nthreads, grain, visit, &v) == ES);
+	for (ssize_t i = 0; i < v.size; i++)
+		assert(v.visits[i] == 1);
+	for (int i = 0; i < nthreads; i++)
+		total += v.counts[i];
+	assert(total == v.size);
+	if (err == ES) {
+		ssize_t pos2;
+
+		assert(excit_pos(it, &pos2) == ES);
+		assert(pos2 == pos);
+	}
+
+	/* the value returned by fn stops the traversal */
+	if (v.size > 0) {
+		v.stop_rank = v.size / 2;
+		for (ssize_t i = 0; i < v.size; i++)
+			v.visits[i] = 0;
+		assert(excit_parallel_for(it, nthreads, grain, visit, &v) ==
+		       42);
+		assert(v.visits[v.stop_rank] == 1);
+		for (ssize_t i = 0; i < v.size; i++)
+			assert(v.visits[i] <= 1);
+	}
+	free(v.expected);
+	free(v.visits);
+	excit_free(it);
+}
+
+/* Checks an element of a large iterator, then stops */
+static int visit_large(const ssize_t *indexes, ssize_t rank, int worker,
+		       void *ctx)
+{
+	const_excit_t it = (const_excit_t)ctx;
+	ssize_t size, expected[2];
+
+	(void)worker;
+	assert(excit_size(it, &size) == ES);
+	assert(rank >= 0 && rank < size);
+	assert(excit_nth(it, rank, expected) == ES);
+	assert(indexes[0] == expected[0] && indexes[1] == expected[1]);
+	return 7;
+}
+
+int main(void)
+{
+	excit_t it;
+	ssize_t arities[3] = { 3, 4, 5 };
+	ssize_t dummy = 0;
+
+	it = create_test_range(0, 3, 1);
+	assert(excit_parallel_for(NULL, 2, 1, visit, &dummy) == -EXCIT_EINVAL);
+	assert(excit_parallel_for(it, 2, 1, NULL, NULL) == -EXCIT_EINVAL);
+	assert(excit_parallel_for(it, -1, 1, visit, &dummy) == -EXCIT_EDOM);
+	assert(excit_parallel_for(it, 2, -1, visit, &dummy) == -EXCIT_EDOM);
+	excit_free(it);
+
+	/* iterators accessed by rank */
+	for (int nthreads = 1; nthreads <= 8; nthreads *= 2) {
+		test_parallel_for(create_test_product2
+				  (create_test_range(0, 99, 1),
+				   create_test_range(-5, 40, 3)), 17, nthreads,
+				  0);
+		test_parallel_for(create_test_product2
+				  (create_test_range(0, 9, 1),
+				   create_test_range(0, 9, 1)), 0, nthreads, 1);
+		test_parallel_for(create_test_range(0, 3, 1), 0, nthreads, 7);
+	}
+	it = excit_alloc_test(EXCIT_TLEAF);
+	assert(excit_tleaf_init(it, 4, arities, NULL, TLEAF_POLICY_SCATTER,
+				NULL) == ES);
+	test_parallel_for(it, 5, 4, 3);
+	it = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(it, 5) == ES);
+	test_parallel_for(it, 0, 3, 0);
+	test_parallel_for(create_test_range(0, -1, 1), 0, 4, 0);
+
+	/* tasks of iterators of about 2^62 elements are handed out */
+	it = create_test_product2(create_test_range(0, (ssize_t)1 << 31, 1),
+				  create_test_range(0, ((ssize_t)1 << 31) - 1,
+						    1));
+	assert(excit_parallel_for(it, 3, 0, visit_large, it) == 7);
+	excit_free(it);
+
+	/* iterators without random access are split */
+	for (int nthreads = 1; nthreads <= 8; nthreads *= 2) {
+		test_parallel_for(create_test_counter(0, 100), 3, nthreads, 0);
+		test_parallel_for(create_test_counter(-2, 3), 0, nthreads, 0);
+	}
+	test_parallel_for(create_test_counter(0, 0), 0, 2, 0);
+	it = create_test_product2(create_test_range(0, 4, 1),
+				  create_test_counter(0, 3));
+	assert(excit_parallel_for(it, 2, 0, visit, &dummy) != ES);
+	excit_free(it);
+	return 0;
+}
@@ -0,0 +1,284 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_product2(excit_t it1, excit_t it2)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it, it1) == ES);
+	assert(excit_product_add(it, it2) == ES);
+	return it;
+}
+
+excit_t create_test_composition(excit_t src, excit_t indexer)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_COMPOSITION);
+	assert(excit_composition_init(it, src, indexer) == ES);
+	return it;
+}
+
+excit_t create_test_repeat(excit_t src, ssize_t n)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_REPEAT);
+	assert(excit_repeat_init(it, src, n) == ES);
+	return it;
+}
+
+excit_t create_test_loop(excit_t src, ssize_t n)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_LOOP);
+	assert(excit_loop_init(it, src, n) == ES);
+	return it;
+}
+
+/*
+ * Checks that plan and ref have the same elements and ranks, and the same
+ * remaining elements from their current position.
+ */
+void test_equivalent(excit_t plan, excit_t ref)
+{
+	ssize_t dim, ref_dim, size, ref_size, rank, ref_rank;
+	ssize_t pos, ref_pos;
+	int err1, err2;
+
+	assert(excit_dimension(plan, &dim) == ES);
+	assert(excit_dimension(ref, &ref_dim) == ES);
+	assert(dim == ref_dim);
+	assert(excit_size(plan, &size) == ES);
+	assert(excit_size(ref, &ref_size) == ES);
+	assert(size == ref_size);
+
+	ssize_t indexes1[dim], indexes2[dim];
+
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_nth(plan, i, indexes1) == ES);
+		assert(excit_nth(ref, i, indexes2) == ES);
+		for (ssize_t j = 0; j < dim; j++)
+			assert(indexes1[j] == indexes2[j]);
+		err1 = excit_rank(plan, indexes1, &rank);
+		err2 = excit_rank(ref, indexes2, &ref_rank);
+		assert(err1 == err2);
+		assert(err1 != ES || rank == ref_rank);
+	}
+	err1 = excit_pos(plan, &pos);
+	err2 = excit_pos(ref, &ref_pos);
+	assert(err1 == err2);
+	assert(err1 != ES || pos == ref_pos);
+	do {
+		err1 = excit_next(plan, indexes1);
+		err2 = excit_next(ref, indexes2);
+		assert(err1 == err2);
+		for (ssize_t j = 0; err1 == ES && j < dim; j++)
+			assert(indexes1[j] == indexes2[j]);
+	} while (err1 == ES);
+	assert(err1 == EXCIT_STOPIT);
+}
+
+/*
+ * Compiles it after skipping some elements, and checks the plan is
+ * equivalent and leaves it untouched.
+ */
+void test_compile(excit_t it, ssize_t skip)
+{
+	excit_t plan;
+	enum excit_type_e type, it_type;
+	ssize_t pos;
+
+	for (ssize_t i = 0; i < skip; i++)
+		assert(excit_skip(it) == ES);
+	assert(excit_type(it, &it_type) == ES);
+	assert(excit_compile(it, &plan) == ES);
+	assert(excit_type(plan, &type) == ES);
+	assert(type == EXCIT_PLAN);
+	assert(excit_type(it, &type) == ES);
+	assert(type == it_type);
+	if (excit_pos(it, &pos) == ES)
+		assert(pos == skip);
+	test_equivalent(plan, it);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t tmp = excit_dup(plan);
+
+		assert(excit_rewind(tmp) == ES);
+		synthetic_tests[i] (tmp);
+		excit_free(tmp);
+		i++;
+	}
+	excit_free(plan);
+	excit_free(it);
+}
+
+/* Parts of plans with close to SSIZE_MAX elements start where expected */
+void test_split_large_plan(void)
+{
+	excit_t it, plan, parts[3];
+	ssize_t indexes1[2], indexes2[2], size, part_size, first = 0;
+
+	it = create_test_product2(create_test_range(0, (ssize_t)1 << 31, 1),
+				  create_test_range(0, ((ssize_t)1 << 31) - 1,
+						    1));
+	assert(excit_compile(it, &plan) == ES);
+	assert(excit_size(plan, &size) == ES);
+	assert(excit_split(plan, 3, parts) == ES);
+	for (int p = 0; p < 3; p++) {
+		assert(excit_size(parts[p], &part_size) == ES);
+		assert(part_size == size / 3 || part_size == size / 3 + 1);
+		assert(excit_next(parts[p], indexes1) == ES);
+		assert(excit_nth(it, first, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		first += part_size;
+		assert(excit_nth(parts[p], part_size - 1, indexes1) == ES);
+		assert(excit_nth(it, first - 1, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		excit_free(parts[p]);
+	}
+	assert(first == size);
+	excit_free(plan);
+	excit_free(it);
+}
+
+/* Iterators of a single element are too small for the synthetic tests */
+void test_compile_single(excit_t it)
+{
+	excit_t plan;
+
+	assert(excit_compile(it, &plan) == ES);
+	test_equivalent(plan, it);
+	assert(excit_rewind(plan) == ES);
+	test_next_batch(plan);
+	excit_free(plan);
+	excit_free(it);
+}
+
+int main(void)
+{
+	excit_t it, inner, parts[3];
+	ssize_t lower[2] = { 4, -1 };
+	ssize_t upper[2] = { 0, 5 };
+	ssize_t step[2] = { -2, 3 };
+	ssize_t strides[2] = { 10, -1 };
+	ssize_t arities[2] = { 2, 3 };
+	ssize_t index;
+
+	assert(excit_compile(NULL, &it) == -EXCIT_EINVAL);
+
+	/* affine trees */
+	inner = create_test_product2(create_test_composition
+				     (create_test_range(10, 40, 3),
+				      create_test_range(1, 7, 2)),
+				     create_test_repeat(create_test_range
+							(-2, 2, 2), 2));
+	it = create_test_product2(create_test_range(0, 3, 1), inner);
+	test_compile(it, 5);
+
+	inner = excit_alloc_test(EXCIT_BOX);
+	assert(excit_box_init(inner, 2, lower, upper, step) == ES);
+	it = create_test_loop(inner, 3);
+	test_compile(it, 11);
+
+	inner = create_test_product2(create_test_range(0, 3, 1),
+				     create_test_range(5, 1, -2));
+	it = excit_alloc_test(EXCIT_OFFSET);
+	assert(excit_offset_init(it, inner, strides, 7) == ES);
+	test_compile(it, 2);
+
+	/* digits that are always 0 */
+	it = create_test_product2(create_test_range(3, 3, 1),
+				  create_test_repeat(create_test_range(0, 4, 1),
+						     1));
+	test_compile(it, 3);
+	/* plans of a single element have no digit at all */
+	test_compile_single(create_test_range(-1, -1, 1));
+	test_compile_single(create_test_product2(create_test_range(3, 3, 1),
+						 create_test_range(0, 0, 1)));
+	it = excit_alloc_test(EXCIT_BOX);
+	assert(excit_box_init(it, 2, upper, upper, step) == ES);
+	test_compile_single(it);
+	inner = create_test_range(-1, -1, 1);
+	assert(excit_compile(inner, &it) == ES);
+	assert(excit_next(it, &index) == ES);
+	assert(index == -1);
+	assert(excit_next(it, &index) == EXCIT_STOPIT);
+	assert(excit_nth(it, 0, &index) == ES);
+	assert(index == -1);
+	excit_free(it);
+	excit_free(inner);
+
+	/* a composition of compositions */
+	inner = create_test_composition(create_test_range(-20, 20, 2),
+					create_test_range(18, 2, -1));
+	it = create_test_composition(inner, create_test_range(0, 16, 4));
+	test_compile(it, 1);
+
+	/* iterators that are not lowered are driven through their table */
+	inner = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(inner, 2) == ES);
+	it = create_test_product2(inner, create_test_range(0, 2, 1));
+	test_compile(it, 9);
+
+	inner = excit_alloc_test(EXCIT_TLEAF);
+	assert(excit_tleaf_init(inner, 3, arities, NULL, TLEAF_POLICY_SCATTER,
+				NULL) == ES);
+	inner = create_test_loop(create_test_repeat(inner, 2), 2);
+	it = create_test_product2(create_test_range(0, 1, 1), inner);
+	test_compile(it, 13);
+
+	inner = create_test_product2(create_test_range(0, 2, 1),
+				     create_test_range(0, 3, 1));
+	it = create_test_composition(inner, create_test_range(1, 9, 2));
+	test_compile(it, 3);
+
+	/* decreasing indexers are folded too */
+	it = create_test_composition(create_test_range(0, 9, 1),
+				     create_test_range(9, 0, -3));
+	test_compile(it, 0);
+
+	/* slices of a product keep their window */
+	it = create_test_product2(create_test_range(0, 4, 1),
+				  create_test_range(0, 2, 1));
+	assert(excit_split(it, 3, parts) == ES);
+	excit_free(it);
+	test_compile(parts[0], 0);
+	test_compile(parts[1], 2);
+	test_compile(parts[2], 4);
+
+	/* the position of a depleted iterator is kept */
+	it = create_test_product2(create_test_range(0, 1, 1),
+				  create_test_range(0, 2, 1));
+	test_compile(it, 6);
+
+	test_split_large_plan();
+	return 0;
+}
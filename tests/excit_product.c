@@ -135,6 +135,7 @@ void test_product_split_dim(void)
 	excit_t its[3];
 	excit_t new_its[3];
 	ssize_t indexes[3];
+	ssize_t size;
 
 	its[0] = create_test_range(0, 3, 1);
 	its[1] = create_test_range(1, -1, -1);
@@ -143,6 +144,13 @@ void test_product_split_dim(void)
 
 	//first
 	assert(excit_product_split_dim(it, 0, 2, new_its) == ES);
+	/* cached sizes must follow the split factor */
+	assert(excit_size(new_its[0], &size) == ES);
+	assert(size == 2 * 3 * 11);
+	assert(excit_nth(new_its[1], size - 1, indexes) == ES);
+	assert(indexes[0] == 3 && indexes[1] == -1 && indexes[2] == 5);
+	assert(excit_rank(new_its[1], indexes, &size) == ES);
+	assert(size == 2 * 3 * 11 - 1);
 	for (int i = 0; i <= 1; i++) {
 		for (int j = 1; j >= -1; j--) {
 			for (int k = -5; k <= 5; k++) {
@@ -229,6 +237,231 @@ void test_product_split_dim(void)
 	excit_free(it);
 }
 
+void test_product_split_slice(excit_t slice)
+{
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = excit_dup(slice);
+
+		assert(it != NULL);
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+void test_product_split(void)
+{
+	excit_t it, it2;
+	excit_t its[3];
+	excit_t new_its[7];
+	ssize_t indexes1[3], indexes2[3];
+	ssize_t size, count, total;
+	enum excit_type_e type;
+
+	its[0] = create_test_range(0, 5, 1);
+	its[1] = create_test_range(1, -1, -1);
+	its[2] = create_test_range(-5, 5, 3);
+	it = create_test_product(3, its);
+
+	for (int n = 1; n <= 7; n++) {
+		assert(excit_split(it, n, new_its) == ES);
+		it2 = excit_dup(it);
+		total = 0;
+		for (int i = 0; i < n; i++) {
+			assert(excit_type(new_its[i], &type) == ES);
+			assert(type == EXCIT_PRODUCT);
+			assert(excit_size(new_its[i], &size) == ES);
+			/* parts are balanced */
+			assert(size == 6 * 3 * 4 / n || size == 6 * 3 * 4 / n + 1);
+			/* outermost cuts keep full inner factors */
+			if (6 % n == 0) {
+				assert(excit_product_split_dim(new_its[i], 2, 2,
+							       NULL) == ES);
+			} else
+				assert(excit_product_split_dim(new_its[i], 2, 2,
+							       NULL) ==
+				       -EXCIT_ENOTSUP);
+			count = 0;
+			while (excit_next(new_its[i], indexes1) == ES) {
+				assert(excit_next(it2, indexes2) == ES);
+				assert(memcmp(indexes1, indexes2,
+					      sizeof(indexes1)) == 0);
+				assert(excit_rank(new_its[i], indexes1, &size)
+				       == ES);
+				assert(size == count);
+				count++;
+			}
+			total += count;
+			excit_free(new_its[i]);
+		}
+		assert(total == 6 * 3 * 4);
+		assert(excit_next(it2, indexes2) == EXCIT_STOPIT);
+		excit_free(it2);
+	}
+
+	/* slices can be split again */
+	assert(excit_split(it, 5, new_its) == ES);
+	test_product_split_slice(new_its[1]);
+	for (int i = 0; i < 5; i++)
+		excit_free(new_its[i]);
+
+	for (int i = 0; i < 3; i++)
+		excit_free(its[i]);
+	excit_free(it);
+}
+
+void test_product_split_grid(void)
+{
+	excit_t it;
+	excit_t its[3];
+	excit_t new_its[12];
+	ssize_t parts[3];
+	ssize_t indexes[3];
+	ssize_t size, rank, total;
+	char seen[6 * 3 * 4];
+
+	its[0] = create_test_range(0, 5, 1);
+	its[1] = create_test_range(1, -1, -1);
+	its[2] = create_test_range(-5, 5, 3);
+	it = create_test_product(3, its);
+
+	assert(excit_product_split_grid_dims(it, 4, parts) == ES);
+	assert(parts[0] == 2 && parts[1] == 1 && parts[2] == 2);
+	assert(excit_product_split_grid_dims(it, 12, parts) == ES);
+	assert(parts[0] == 3 && parts[1] == 2 && parts[2] == 2);
+	assert(excit_product_split_grid_dims(it, 7, parts) == -EXCIT_EDOM);
+	assert(excit_product_split_grid_dims(it, 0, parts) == -EXCIT_EDOM);
+
+	parts[0] = 7;
+	parts[1] = 1;
+	parts[2] = 1;
+	assert(excit_product_split_grid(it, parts, NULL) == -EXCIT_EDOM);
+
+	assert(excit_product_split_grid_dims(it, 12, parts) == ES);
+	assert(excit_product_split_grid(it, parts, NULL) == ES);
+	assert(excit_product_split_grid(it, parts, new_its) == ES);
+	memset(seen, 0, sizeof(seen));
+	total = 0;
+	for (int i = 0; i < 12; i++) {
+		assert(excit_size(new_its[i], &size) == ES);
+		assert(size == 2 * 1 * 2 || size == 2 * 2 * 2);
+		total += size;
+		while (excit_next(new_its[i], indexes) == ES) {
+			assert(excit_rank(it, indexes, &rank) == ES);
+			assert(!seen[rank]);
+			seen[rank] = 1;
+		}
+		excit_free(new_its[i]);
+	}
+	assert(total == 6 * 3 * 4);
+
+	/* the first block holds the corner of the grid */
+	assert(excit_product_split_grid(it, parts, new_its) == ES);
+	assert(excit_nth(new_its[0], 0, indexes) == ES);
+	assert(indexes[0] == 0 && indexes[1] == 1 && indexes[2] == -5);
+	assert(excit_nth(new_its[11], 0, indexes) == ES);
+	assert(indexes[0] == 4 && indexes[1] == -1 && indexes[2] == 1);
+	for (int i = 0; i < 12; i++)
+		excit_free(new_its[i]);
+
+	for (int i = 0; i < 3; i++)
+		excit_free(its[i]);
+	excit_free(it);
+}
+
+void test_product_next_delta(void)
+{
+	excit_t it;
+	excit_t its[3];
+	ssize_t indexes[3];
+	ssize_t first_changed_dim;
+
+	its[0] = create_test_range(0, 1, 1);
+	its[1] = create_test_range(1, -1, -1);
+	its[2] = create_test_range(-5, 5, 3);
+	it = create_test_product(3, its);
+
+	for (ssize_t i = 0; i < 2 * 3 * 4; i++) {
+		assert(excit_next_delta(it, indexes, &first_changed_dim) == ES);
+		if (i == 0 || i == 3 * 4)
+			assert(first_changed_dim == 0);
+		else if (i % 4 == 0)
+			assert(first_changed_dim == 1);
+		else
+			assert(first_changed_dim == 2);
+	}
+	assert(excit_next_delta(it, indexes, &first_changed_dim) ==
+	       EXCIT_STOPIT);
+
+	assert(excit_seek(it, 5) == ES);
+	assert(excit_next_delta(it, indexes, &first_changed_dim) == ES);
+	assert(first_changed_dim == 0);
+	assert(excit_next_delta(it, indexes, &first_changed_dim) == ES);
+	assert(first_changed_dim == 2);
+
+	for (int i = 0; i < 3; i++)
+		excit_free(its[i]);
+	excit_free(it);
+}
+
+void test_product_collapse(void)
+{
+	excit_t it, ref, slices[2];
+	excit_t its[5];
+	ssize_t indexes1[6], indexes2[6];
+	ssize_t count;
+
+	its[0] = create_test_range(0, 2, 1);
+	its[1] = create_test_range(1, -1, -1);
+	its[2] = create_test_product(2, its);
+	its[3] = create_test_range(-5, 5, 3);
+	its[4] = create_test_range(4, 5, 1);
+	it = create_test_product(5, its);
+	ref = excit_dup(it);
+
+	/* Position is kept across the collapse */
+	for (int i = 0; i < 100; i++) {
+		assert(excit_next(it, indexes1) == ES);
+		assert(excit_next(ref, indexes2) == ES);
+	}
+	assert(excit_product_collapse(it) == ES);
+	assert(excit_product_count(it, &count) == ES);
+	assert(count == 3);
+	while (excit_next(ref, indexes2) == ES) {
+		assert(excit_next(it, indexes1) == ES);
+		for (int i = 0; i < 6; i++)
+			assert(indexes1[i] == indexes2[i]);
+	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+	assert(excit_rewind(it) == ES);
+	test_product_split_slice(it);
+
+	/* So is the window of a slice */
+	assert(excit_split(ref, 2, slices) == ES);
+	excit_free(it);
+	it = excit_dup(slices[1]);
+	assert(excit_next(it, indexes1) == ES);
+	assert(excit_product_collapse(it) == ES);
+	assert(excit_next(slices[1], indexes2) == ES);
+	while (excit_next(slices[1], indexes2) == ES) {
+		assert(excit_next(it, indexes1) == ES);
+		for (int i = 0; i < 6; i++)
+			assert(indexes1[i] == indexes2[i]);
+	}
+	assert(excit_next(it, indexes1) == EXCIT_STOPIT);
+	assert(excit_rewind(it) == ES);
+	test_product_split_slice(it);
+
+	for (int i = 0; i < 5; i++)
+		excit_free(its[i]);
+	for (int i = 0; i < 2; i++)
+		excit_free(slices[i]);
+	excit_free(it);
+	excit_free(ref);
+}
+
 int main(void)
 {
 	excit_t its[4];
@@ -245,5 +478,17 @@ int main(void)
 	for (int i = 0; i < 4; i++)
 		excit_free(its[i]);
 
+	/* Only ranges with a step of 1 */
+	its[0] = create_test_range(0, 3, 1);
+	its[1] = create_test_range(-2, 0, 1);
+	its[2] = create_test_range(5, 9, 1);
+	test_product_iterator(3, its);
+	for (int i = 0; i < 3; i++)
+		excit_free(its[i]);
+
 	test_product_split_dim();
+	test_product_split();
+	test_product_split_grid();
+	test_product_next_delta();
+	test_product_collapse();
 }
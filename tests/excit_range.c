@@ -80,6 +80,7 @@ int main(void)
 {
 	test_range_iterator(4, 12, 3);
 	test_range_iterator(0, 3, 1);
+	test_range_iterator(-7, 8, 1);
 	test_range_iterator(0, 6, 2);
 	test_range_iterator(-15, 14, 2);
 	test_range_iterator(3, 0, -1);
@@ -205,6 +205,214 @@ void test_skip(excit_t it1)
 	excit_free(it2);
 }
 
+void test_next_batch(excit_t it1)
+{
+	excit_t it2;
+	ssize_t dim1, produced;
+	ssize_t batch_sizes[] = { 1, 3, 7 };
+
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *indexes1, *indexes2;
+	ssize_t buff_dim = dim1 * sizeof(ssize_t);
+
+	indexes1 = (ssize_t *) malloc(buff_dim);
+	indexes2 = (ssize_t *) malloc(7 * buff_dim);
+
+	for (int i = 0; i < 3; i++) {
+		it2 = excit_dup_test(it1);
+		while (excit_next_batch(it2, batch_sizes[i], indexes2,
+					&produced) == ES) {
+			assert(produced > 0 && produced <= batch_sizes[i]);
+			for (ssize_t j = 0; j < produced; j++) {
+				assert(excit_next(it1, indexes1) == ES);
+				assert(memcmp(indexes1, indexes2 + j * dim1,
+					      buff_dim) == 0);
+			}
+		}
+		assert(excit_next(it1, indexes1) == EXCIT_STOPIT);
+		assert(excit_next_batch(it2, 1, NULL, &produced) ==
+		       EXCIT_STOPIT);
+		assert(excit_rewind(it1) == ES);
+		excit_free(it2);
+	}
+	assert(excit_next_batch(it1, 0, indexes2, &produced) == -EXCIT_EDOM);
+
+	free(indexes1);
+	free(indexes2);
+}
+
+void test_next_ref(excit_t it1)
+{
+	excit_t it2;
+	ssize_t dim1, count;
+	const ssize_t *tuple;
+
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *indexes1, *indexes2;
+	ssize_t buff_dim = dim1 * sizeof(ssize_t);
+
+	indexes1 = (ssize_t *) malloc(buff_dim);
+	indexes2 = (ssize_t *) malloc(buff_dim);
+
+	it2 = excit_dup_test(it1);
+	while (excit_next_ref(it2, &tuple) == ES) {
+		assert(excit_next(it1, indexes1) == ES);
+		assert(memcmp(tuple, indexes1, buff_dim) == 0);
+		/* peeking does not invalidate the returned element */
+		excit_peek(it2, indexes2);
+		assert(memcmp(tuple, indexes1, buff_dim) == 0);
+	}
+	assert(excit_next(it1, indexes1) == EXCIT_STOPIT);
+	assert(excit_next_ref(it2, &tuple) == EXCIT_STOPIT);
+
+	/* interleaved with next */
+	assert(excit_rewind(it1) == ES);
+	assert(excit_rewind(it2) == ES);
+	for (count = 0; excit_next(it1, indexes1) == ES; count++) {
+		if (count % 2) {
+			assert(excit_next(it2, indexes2) == ES);
+			assert(memcmp(indexes2, indexes1, buff_dim) == 0);
+		} else {
+			assert(excit_next_ref(it2, &tuple) == ES);
+			assert(memcmp(tuple, indexes1, buff_dim) == 0);
+		}
+	}
+	assert(excit_next_ref(it2, &tuple) == EXCIT_STOPIT);
+	assert(excit_rewind(it1) == ES);
+	assert(excit_next_ref(it1, NULL) == -EXCIT_EINVAL);
+	excit_free(it2);
+
+	free(indexes1);
+	free(indexes2);
+}
+
+void test_next_delta(excit_t it1)
+{
+	excit_t it2;
+	ssize_t dim1, first_changed_dim;
+
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *indexes1, *indexes2, *previous;
+	ssize_t buff_dim = dim1 * sizeof(ssize_t);
+
+	indexes1 = (ssize_t *) malloc(buff_dim);
+	indexes2 = (ssize_t *) malloc(buff_dim);
+	previous = (ssize_t *) malloc(buff_dim);
+
+	it2 = excit_dup_test(it1);
+	for (int i = 0; excit_next_delta(it2, indexes2, &first_changed_dim)
+	     == ES; i++) {
+		assert(excit_next(it1, indexes1) == ES);
+		assert(memcmp(indexes1, indexes2, buff_dim) == 0);
+		assert(first_changed_dim >= 0 && first_changed_dim <= dim1);
+		if (i == 0)
+			assert(first_changed_dim == 0);
+		else
+			assert(memcmp(previous, indexes2,
+				      first_changed_dim * sizeof(ssize_t)) ==
+			       0);
+		memcpy(previous, indexes2, buff_dim);
+	}
+	assert(excit_next(it1, indexes1) == EXCIT_STOPIT);
+	assert(excit_next_delta(it2, NULL, &first_changed_dim) ==
+	       EXCIT_STOPIT);
+	assert(excit_rewind(it1) == ES);
+	assert(excit_next_delta(it1, NULL, NULL) == -EXCIT_EINVAL);
+	excit_free(it2);
+
+	free(indexes1);
+	free(indexes2);
+	free(previous);
+}
+
+static ssize_t *collect_elements(excit_t it, ssize_t *size)
+{
+	excit_t it2 = excit_dup_test(it);
+	ssize_t dim, count = 0, capacity = 16;
+	ssize_t *elements;
+
+	excit_dimension_test(it2, &dim);
+	elements = (ssize_t *) malloc(capacity * dim * sizeof(ssize_t));
+	assert(elements != NULL);
+	for (;;) {
+		if (count == capacity) {
+			capacity *= 2;
+			elements = (ssize_t *) realloc(elements,
+						       capacity * dim *
+						       sizeof(ssize_t));
+			assert(elements != NULL);
+		}
+		if (excit_next(it2, elements + count * dim) != ES)
+			break;
+		count++;
+	}
+	excit_free(it2);
+	*size = count;
+	return elements;
+}
+
+void test_seek(excit_t it1)
+{
+	excit_t it2;
+	ssize_t size, dim1, rank;
+	ssize_t *elements = collect_elements(it1, &size);
+
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *indexes = (ssize_t *) malloc(dim1 * sizeof(ssize_t));
+	ssize_t buff_dim = dim1 * sizeof(ssize_t);
+
+	it2 = excit_dup_test(it1);
+	assert(excit_seek(it2, -1) == -EXCIT_EDOM);
+	assert(excit_seek(it2, size + 1) == -EXCIT_EDOM);
+	assert(excit_seek(it2, size) == ES);
+	assert(excit_peek(it2, indexes) == EXCIT_STOPIT);
+	assert(excit_next(it2, indexes) == EXCIT_STOPIT);
+	/* seek backward */
+	for (ssize_t i = size - 1; i >= 0; i--) {
+		assert(excit_seek(it2, i) == ES);
+		if (excit_pos(it2, &rank) != -EXCIT_ENOTSUP) {
+			assert(excit_pos(it2, &rank) == ES);
+			assert(rank == i);
+		}
+		assert(excit_peek(it2, indexes) == ES);
+		assert(memcmp(indexes, elements + i * dim1, buff_dim) == 0);
+		assert(excit_next(it2, indexes) == ES);
+		assert(memcmp(indexes, elements + i * dim1, buff_dim) == 0);
+	}
+	/* seek forward, then walk to the end */
+	assert(excit_seek(it2, size / 2) == ES);
+	for (ssize_t i = size / 2; i < size; i++) {
+		assert(excit_next(it2, indexes) == ES);
+		assert(memcmp(indexes, elements + i * dim1, buff_dim) == 0);
+	}
+	assert(excit_next(it2, indexes) == EXCIT_STOPIT);
+	excit_free(it2);
+
+	/* advance by a few elements at a time */
+	for (ssize_t k = 0; k < 4; k++) {
+		it2 = excit_dup_test(it1);
+		for (ssize_t i = 0; i < size; i += k + 1) {
+			assert(excit_next(it2, indexes) == ES);
+			assert(memcmp(indexes, elements + i * dim1,
+				      buff_dim) == 0);
+			if (i + k < size)
+				assert(excit_advance(it2, k) == ES);
+			else
+				assert(excit_advance(it2, k) == EXCIT_STOPIT);
+		}
+		assert(excit_next(it2, indexes) == EXCIT_STOPIT);
+		excit_free(it2);
+	}
+	assert(excit_advance(it1, -1) == -EXCIT_EDOM);
+
+	free(indexes);
+	free(elements);
+}
+
 void test_pos(excit_t it)
 {
 	ssize_t rank, expected_rank;
@@ -256,6 +464,69 @@ void test_nth(excit_t it1)
 	excit_free(it2);
 }
 
+void test_nth_batch(excit_t it1)
+{
+	ssize_t size, dim1;
+
+	if (excit_nth(it1, 0, NULL) == -EXCIT_ENOTSUP)
+		return;
+	assert(excit_size(it1, &size) == ES);
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *ranks = (ssize_t *) malloc(size * sizeof(ssize_t));
+	ssize_t *indexes1 = (ssize_t *) malloc(dim1 * sizeof(ssize_t));
+	ssize_t *indexes2 = (ssize_t *) malloc(size * dim1 * sizeof(ssize_t));
+
+	/* Reverse order to exercise non-sequential accesses */
+	for (ssize_t i = 0; i < size; i++)
+		ranks[i] = size - 1 - i;
+	assert(excit_nth_batch(it1, size, ranks, indexes2) == ES);
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_nth(it1, ranks[i], indexes1) == ES);
+		assert(memcmp(indexes1, indexes2 + i * dim1,
+			      dim1 * sizeof(ssize_t)) == 0);
+	}
+	ranks[0] = size;
+	assert(excit_nth_batch(it1, size, ranks, indexes2) == -EXCIT_EDOM);
+	assert(excit_nth_batch(it1, 0, ranks, indexes2) == -EXCIT_EDOM);
+
+	free(ranks);
+	free(indexes1);
+	free(indexes2);
+}
+
+void test_rank_batch(excit_t it1)
+{
+	ssize_t size, dim1, rank;
+
+	if (excit_nth(it1, 0, NULL) == -EXCIT_ENOTSUP)
+		return;
+	assert(excit_size(it1, &size) == ES);
+	excit_dimension_test(it1, &dim1);
+
+	ssize_t *ranks1 = (ssize_t *) malloc(size * sizeof(ssize_t));
+	ssize_t *ranks2 = (ssize_t *) malloc(size * sizeof(ssize_t));
+	ssize_t *indexes = (ssize_t *) malloc(size * dim1 * sizeof(ssize_t));
+
+	for (ssize_t i = 0; i < size; i++)
+		ranks1[i] = size - 1 - i;
+	assert(excit_nth_batch(it1, size, ranks1, indexes) == ES);
+	if (excit_rank(it1, indexes, &rank) != ES)
+		goto exit;
+	assert(excit_rank_batch(it1, size, indexes, ranks2) == ES);
+	for (ssize_t i = 0; i < size; i++) {
+		assert(excit_rank(it1, indexes + i * dim1, &rank) == ES);
+		assert(rank == ranks2[i]);
+	}
+	for (int i = 0; i < dim1; i++)
+		indexes[(size - 1) * dim1 + i] = 0xDEADBEEFDEADBEEF;
+	assert(excit_rank_batch(it1, size, indexes, ranks2) == -EXCIT_EINVAL);
+exit:
+	free(ranks1);
+	free(ranks2);
+	free(indexes);
+}
+
 void test_rank(excit_t it1)
 {
 	excit_t it2;
@@ -333,4 +604,9 @@ void (*synthetic_tests[]) (excit_t) = {
 	    &test_peek,
 	    &test_rewind,
 	    &test_cyclic_next,
-	    &test_pos, &test_nth, &test_rank, &test_split, NULL};
+	    &test_next_batch,
+	    &test_next_ref,
+	    &test_next_delta,
+	    &test_seek,
+	    &test_pos, &test_nth, &test_rank, &test_nth_batch,
+	    &test_rank_batch, &test_split, NULL};
@@ -16,4 +16,7 @@
 extern excit_t excit_alloc_test(enum excit_type_e type);
 
 extern void (*synthetic_tests[]) (excit_t);
+
+/* Synthetic tests that also apply to iterators of a single element */
+extern void test_next_batch(excit_t it1);
 #endif
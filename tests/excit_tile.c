@@ -0,0 +1,292 @@
+/*******************************************************************************
+ * Copyright 2019 UChicago Argonne, LLC.
+ * (c.f. AUTHORS, LICENSE)
+ *
+ * This file is part of the EXCIT project.
+ * For more info, see https://github.com/anlsys/excit
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ ******************************************************************************/
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "excit.h"
+#include "excit_test.h"
+
+excit_t create_test_range(ssize_t start, ssize_t stop, ssize_t step)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_RANGE);
+	assert(excit_range_init(it, start, stop, step) == ES);
+	return it;
+}
+
+excit_t create_test_tile(int dim, const ssize_t *shape, const ssize_t *tile,
+			 excit_t outer, const ssize_t *inner)
+{
+	excit_t it;
+
+	it = excit_alloc_test(EXCIT_TILE);
+	assert(excit_tile_init(it, dim, shape, tile,
+			       outer ? excit_dup(outer) : NULL, inner) == ES);
+	return it;
+}
+
+void test_alloc_init_tile(int dim, const ssize_t *shape, const ssize_t *tile,
+			  excit_t outer, const ssize_t *inner)
+{
+	excit_t it;
+	ssize_t d, size, expected_size = 1;
+	ssize_t bad_inner[dim];
+
+	it = excit_alloc_test(EXCIT_TILE);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == 0);
+	/* uninitialized iterators are empty */
+	assert(excit_size(it, &size) == ES);
+	assert(size == 0);
+	assert(excit_rewind(it) == ES);
+	assert(excit_seek(it, 0) == ES);
+	assert(excit_peek(it, NULL) == EXCIT_STOPIT);
+	assert(excit_next(it, NULL) == EXCIT_STOPIT);
+	assert(excit_pos(it, NULL) == EXCIT_STOPIT);
+
+	for (int i = 0; i < dim; i++)
+		bad_inner[i] = 0;
+	assert(excit_tile_init(it, 0, shape, tile, NULL, NULL) ==
+	       -EXCIT_EINVAL);
+	assert(excit_tile_init(it, dim, shape, NULL, NULL, NULL) ==
+	       -EXCIT_EINVAL);
+	if (dim > 1)
+		assert(excit_tile_init(it, dim, shape, tile, NULL, bad_inner)
+		       == -EXCIT_EINVAL);
+	assert(excit_tile_init(it, dim, shape, tile,
+			       outer ? excit_dup(outer) : NULL, inner) == ES);
+	assert(excit_dimension(it, &d) == ES);
+	assert(d == dim);
+	for (int i = 0; i < dim; i++)
+		expected_size *= shape[i];
+	assert(excit_size(it, &size) == ES);
+	assert(size == expected_size);
+
+	excit_free(it);
+}
+
+/*
+ * Checks that every point of the box is visited once, tile after tile.
+ */
+void test_next_tile(int dim, const ssize_t *shape, const ssize_t *tile,
+		    excit_t outer, const ssize_t *inner)
+{
+	excit_t it = create_test_tile(dim, shape, tile, outer, inner);
+	ssize_t size, ntiles = 1, cur = -1;
+	ssize_t indexes[dim];
+	char *visited, *tile_visited;
+
+	assert(excit_size(it, &size) == ES);
+	for (int i = 0; i < dim; i++)
+		ntiles *= (shape[i] + tile[i] - 1) / tile[i];
+	visited = calloc(size, 1);
+	tile_visited = calloc(ntiles, 1);
+	for (ssize_t i = 0; i < size; i++) {
+		ssize_t cell = 0, t = 0;
+
+		assert(excit_next(it, indexes) == ES);
+		for (int j = 0; j < dim; j++) {
+			assert(indexes[j] >= 0 && indexes[j] < shape[j]);
+			cell = cell * shape[j] + indexes[j];
+			t = t * ((shape[j] + tile[j] - 1) / tile[j]) +
+			    indexes[j] / tile[j];
+		}
+		assert(!visited[cell]);
+		visited[cell] = 1;
+		if (t != cur) {
+			assert(!tile_visited[t]);
+			tile_visited[t] = 1;
+			cur = t;
+		}
+	}
+	assert(excit_next(it, indexes) == EXCIT_STOPIT);
+
+	free(visited);
+	free(tile_visited);
+	excit_free(it);
+}
+
+void test_tile_iterator(int dim, const ssize_t *shape, const ssize_t *tile,
+			excit_t outer, const ssize_t *inner)
+{
+	test_alloc_init_tile(dim, shape, tile, outer, inner);
+
+	test_next_tile(dim, shape, tile, outer, inner);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t it = create_test_tile(dim, shape, tile, outer, inner);
+
+		synthetic_tests[i] (it);
+		excit_free(it);
+		i++;
+	}
+}
+
+/*
+ * Checks that an iterator with fewer tiles than parts is split into windows
+ * of elements, which can be split again.
+ */
+void test_split_tile(void)
+{
+	ssize_t shape[2] = { 40, 25 };
+	ssize_t tile[2] = { 20, 25 };
+	ssize_t indexes1[2], indexes2[2];
+	ssize_t size, part_size, total = 0, rank;
+	excit_t it, parts[4], subparts[3];
+
+	it = create_test_tile(2, shape, tile, NULL, NULL);
+	assert(excit_split(it, 4, parts) == ES);
+	for (int p = 0; p < 4; p++) {
+		assert(excit_size(parts[p], &size) == ES);
+		assert(size == 250);
+		for (ssize_t i = 0; i < size; i++) {
+			assert(excit_next(parts[p], indexes1) == ES);
+			assert(excit_nth(it, total + i, indexes2) == ES);
+			assert(indexes1[0] == indexes2[0]
+			       && indexes1[1] == indexes2[1]);
+			assert(excit_rank(parts[p], indexes1, &rank) == ES);
+			assert(rank == i);
+		}
+		assert(excit_next(parts[p], indexes1) == EXCIT_STOPIT);
+		/* elements of the other parts are not ranked */
+		assert(excit_nth(it, (p + 1) % 4 * 250, indexes2) == ES);
+		assert(excit_rank(parts[p], indexes2, &rank) == -EXCIT_EINVAL);
+		total += size;
+	}
+
+	/* parts of a single tile are not aligned on tiles */
+	assert(excit_rewind(parts[1]) == ES);
+	assert(excit_split(parts[1], 3, subparts) == ES);
+	total = 250;
+	for (int p = 0; p < 3; p++) {
+		assert(excit_size(subparts[p], &part_size) == ES);
+		for (ssize_t i = 0; i < part_size; i++) {
+			assert(excit_next(subparts[p], indexes1) == ES);
+			assert(excit_nth(it, total + i, indexes2) == ES);
+			assert(indexes1[0] == indexes2[0]
+			       && indexes1[1] == indexes2[1]);
+		}
+		total += part_size;
+		excit_free(subparts[p]);
+	}
+	assert(total == 500);
+
+	int i = 0;
+
+	while (synthetic_tests[i]) {
+		excit_t tmp = excit_dup(parts[2]);
+
+		assert(excit_rewind(tmp) == ES);
+		synthetic_tests[i] (tmp);
+		excit_free(tmp);
+		i++;
+	}
+	for (int p = 0; p < 4; p++)
+		excit_free(parts[p]);
+	excit_free(it);
+}
+
+/* Parts of tilings with close to SSIZE_MAX elements start where expected */
+void test_split_large_tile(void)
+{
+	ssize_t shape[2] = { (ssize_t)1 << 31, (ssize_t)1 << 31 };
+	ssize_t tile[2] = { (ssize_t)1 << 30, (ssize_t)1 << 31 };
+	ssize_t indexes1[2], indexes2[2], size, part_size, first = 0;
+	excit_t it, parts[3];
+
+	it = create_test_tile(2, shape, tile, NULL, NULL);
+	assert(excit_size(it, &size) == ES);
+	assert(excit_split(it, 3, parts) == ES);
+	for (int p = 0; p < 3; p++) {
+		assert(excit_size(parts[p], &part_size) == ES);
+		assert(part_size == size / 3 || part_size == size / 3 + 1);
+		assert(excit_next(parts[p], indexes1) == ES);
+		assert(excit_nth(it, first, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		first += part_size;
+		assert(excit_nth(parts[p], part_size - 1, indexes1) == ES);
+		assert(excit_nth(it, first - 1, indexes2) == ES);
+		assert(indexes1[0] == indexes2[0]
+		       && indexes1[1] == indexes2[1]);
+		excit_free(parts[p]);
+	}
+	assert(first == size);
+	excit_free(it);
+}
+
+void test_tile_auto(void)
+{
+	ssize_t shape1[2] = { 1000, 1000 };
+	ssize_t shape2[2] = { 1000, 20 };
+	ssize_t shape3[3] = { 100, 100, 100 };
+	ssize_t tiles[3], size;
+	excit_t it;
+	int err;
+
+	assert(excit_tile_sizes(2, shape1, 8, 49152, 64, tiles) == ES);
+	assert(tiles[0] == 64 && tiles[1] == 48);
+	assert(excit_tile_sizes(2, shape2, 8, 49152, 64, tiles) == ES);
+	assert(tiles[0] == 153 && tiles[1] == 20);
+	assert(excit_tile_sizes(3, shape3, 8, 32768, 64, tiles) == ES);
+	assert(tiles[0] == 16 && tiles[1] == 16 && tiles[2] == 8);
+	assert(excit_tile_sizes(2, shape1, 0, 49152, 64, tiles) ==
+	       -EXCIT_EINVAL);
+
+	it = excit_alloc_test(EXCIT_TILE);
+	err = excit_tile_auto(it, 3, shape3, 8, 1);
+	assert(err == ES || err == -EXCIT_ENOTSUP);
+	if (err == ES) {
+		assert(excit_size(it, &size) == ES);
+		assert(size == 100 * 100 * 100);
+	}
+	excit_free(it);
+}
+
+int main(void)
+{
+	ssize_t shape1[2] = { 7, 5 };
+	ssize_t tile1[2] = { 3, 2 };
+	ssize_t shape2[2] = { 15, 13 };
+	ssize_t tile2[2] = { 4, 4 };
+	ssize_t inner2[2] = { 1, 0 };
+	ssize_t shape3[3] = { 5, 4, 6 };
+	ssize_t tile3[3] = { 2, 4, 4 };
+	ssize_t inner3[3] = { 2, 0, 1 };
+	excit_t it1, it2, it3;
+
+	test_tile_iterator(2, shape1, tile1, NULL, NULL);
+
+	it1 = excit_alloc_test(EXCIT_HILBERT2D);
+	assert(excit_hilbert2d_init(it1, 2) == ES);
+	test_tile_iterator(2, shape2, tile2, it1, inner2);
+
+	it2 = excit_alloc_test(EXCIT_PRODUCT);
+	assert(excit_product_add(it2, create_test_range(2, 0, -1)) == ES);
+	assert(excit_product_add(it2, create_test_range(0, 0, 1)) == ES);
+	assert(excit_product_add(it2, create_test_range(0, 1, 1)) == ES);
+	test_tile_iterator(3, shape3, tile3, it2, inner3);
+
+	it3 = create_test_range(5, 0, -1);
+	test_tile_iterator(3, shape3, tile3, it3, NULL);
+
+	excit_free(it1);
+	excit_free(it2);
+	excit_free(it3);
+
+	test_split_tile();
+	test_split_large_tile();
+	test_tile_auto();
+	return 0;
+}
@@ -260,5 +260,13 @@ int main(void)
 
 	run_tests(depth, arities_1);
 
+	/* trees deeper than the stack buffers of the const functions */
+	depth = 18;
+	const ssize_t arities_2[18] = { 2, 1, 3, 1, 2, 1, 1, 2, 1,
+		1, 2, 1, 1, 3, 1, 1, 2, 4
+	};
+
+	run_tests(depth, arities_2);
+
 	return 0;
 }